@@ -11,8 +11,8 @@ Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
 // bemdR
-ComplexMatrix bemdR(ComplexVector input, NumericVector directions, double num_imfs, unsigned int num_siftings);
-RcppExport SEXP _Rlibeemd_bemdR(SEXP inputSEXP, SEXP directionsSEXP, SEXP num_imfsSEXP, SEXP num_siftingsSEXP) {
+ComplexMatrix bemdR(ComplexVector input, NumericVector directions, double num_imfs, unsigned int num_siftings, int interpolation, int threads, SEXP context);
+RcppExport SEXP _Rlibeemd_bemdR(SEXP inputSEXP, SEXP directionsSEXP, SEXP num_imfsSEXP, SEXP num_siftingsSEXP, SEXP interpolationSEXP, SEXP threadsSEXP, SEXP contextSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -20,13 +20,16 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< NumericVector >::type directions(directionsSEXP);
     Rcpp::traits::input_parameter< double >::type num_imfs(num_imfsSEXP);
     Rcpp::traits::input_parameter< unsigned int >::type num_siftings(num_siftingsSEXP);
-    rcpp_result_gen = Rcpp::wrap(bemdR(input, directions, num_imfs, num_siftings));
+    Rcpp::traits::input_parameter< int >::type interpolation(interpolationSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type context(contextSEXP);
+    rcpp_result_gen = Rcpp::wrap(bemdR(input, directions, num_imfs, num_siftings, interpolation, threads, context));
     return rcpp_result_gen;
 END_RCPP
 }
 // ceemdanR
-NumericMatrix ceemdanR(NumericVector input, double num_imfs, unsigned int ensemble_size, double noise_strength, unsigned int S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads);
-RcppExport SEXP _Rlibeemd_ceemdanR(SEXP inputSEXP, SEXP num_imfsSEXP, SEXP ensemble_sizeSEXP, SEXP noise_strengthSEXP, SEXP S_numberSEXP, SEXP num_siftingsSEXP, SEXP rng_seedSEXP, SEXP threadsSEXP) {
+NumericMatrix ceemdanR(NumericVector input, double num_imfs, unsigned int ensemble_size, double noise_strength, unsigned int S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads, int rng, double tolerance, int stopping, SEXP stopping_thresholds, int interpolation, double memory_limit, bool stats, SEXP context, bool improved);
+RcppExport SEXP _Rlibeemd_ceemdanR(SEXP inputSEXP, SEXP num_imfsSEXP, SEXP ensemble_sizeSEXP, SEXP noise_strengthSEXP, SEXP S_numberSEXP, SEXP num_siftingsSEXP, SEXP rng_seedSEXP, SEXP threadsSEXP, SEXP rngSEXP, SEXP toleranceSEXP, SEXP stoppingSEXP, SEXP stopping_thresholdsSEXP, SEXP interpolationSEXP, SEXP memory_limitSEXP, SEXP statsSEXP, SEXP contextSEXP, SEXP improvedSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -38,13 +41,60 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< unsigned int >::type num_siftings(num_siftingsSEXP);
     Rcpp::traits::input_parameter< unsigned long int >::type rng_seed(rng_seedSEXP);
     Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
-    rcpp_result_gen = Rcpp::wrap(ceemdanR(input, num_imfs, ensemble_size, noise_strength, S_number, num_siftings, rng_seed, threads));
+    Rcpp::traits::input_parameter< int >::type rng(rngSEXP);
+    Rcpp::traits::input_parameter< double >::type tolerance(toleranceSEXP);
+    Rcpp::traits::input_parameter< int >::type stopping(stoppingSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type stopping_thresholds(stopping_thresholdsSEXP);
+    Rcpp::traits::input_parameter< int >::type interpolation(interpolationSEXP);
+    Rcpp::traits::input_parameter< double >::type memory_limit(memory_limitSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type context(contextSEXP);
+    Rcpp::traits::input_parameter< bool >::type improved(improvedSEXP);
+    rcpp_result_gen = Rcpp::wrap(ceemdanR(input, num_imfs, ensemble_size, noise_strength, S_number, num_siftings, rng_seed, threads, rng, tolerance, stopping, stopping_thresholds, interpolation, memory_limit, stats, context, improved));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ceemdan_batchR
+List ceemdan_batchR(List inputs, double num_imfs, unsigned int ensemble_size, double noise_strength, unsigned int S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads, int rng, double tolerance, int stopping, SEXP stopping_thresholds, int interpolation, double memory_limit, bool stats, SEXP context, bool improved);
+RcppExport SEXP _Rlibeemd_ceemdan_batchR(SEXP inputsSEXP, SEXP num_imfsSEXP, SEXP ensemble_sizeSEXP, SEXP noise_strengthSEXP, SEXP S_numberSEXP, SEXP num_siftingsSEXP, SEXP rng_seedSEXP, SEXP threadsSEXP, SEXP rngSEXP, SEXP toleranceSEXP, SEXP stoppingSEXP, SEXP stopping_thresholdsSEXP, SEXP interpolationSEXP, SEXP memory_limitSEXP, SEXP statsSEXP, SEXP contextSEXP, SEXP improvedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< List >::type inputs(inputsSEXP);
+    Rcpp::traits::input_parameter< double >::type num_imfs(num_imfsSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type ensemble_size(ensemble_sizeSEXP);
+    Rcpp::traits::input_parameter< double >::type noise_strength(noise_strengthSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type S_number(S_numberSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type num_siftings(num_siftingsSEXP);
+    Rcpp::traits::input_parameter< unsigned long int >::type rng_seed(rng_seedSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< int >::type rng(rngSEXP);
+    Rcpp::traits::input_parameter< double >::type tolerance(toleranceSEXP);
+    Rcpp::traits::input_parameter< int >::type stopping(stoppingSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type stopping_thresholds(stopping_thresholdsSEXP);
+    Rcpp::traits::input_parameter< int >::type interpolation(interpolationSEXP);
+    Rcpp::traits::input_parameter< double >::type memory_limit(memory_limitSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type context(contextSEXP);
+    Rcpp::traits::input_parameter< bool >::type improved(improvedSEXP);
+    rcpp_result_gen = Rcpp::wrap(ceemdan_batchR(inputs, num_imfs, ensemble_size, noise_strength, S_number, num_siftings, rng_seed, threads, rng, tolerance, stopping, stopping_thresholds, interpolation, memory_limit, stats, context, improved));
+    return rcpp_result_gen;
+END_RCPP
+}
+// emd_contextR
+SEXP emd_contextR(SEXP noise_cache);
+RcppExport SEXP _Rlibeemd_emd_contextR(SEXP noise_cacheSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type noise_cache(noise_cacheSEXP);
+    rcpp_result_gen = Rcpp::wrap(emd_contextR(noise_cache));
     return rcpp_result_gen;
 END_RCPP
 }
 // eemdR
-NumericMatrix eemdR(NumericVector input, double num_imfs, unsigned int ensemble_size, double noise_strength, unsigned int S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads);
-RcppExport SEXP _Rlibeemd_eemdR(SEXP inputSEXP, SEXP num_imfsSEXP, SEXP ensemble_sizeSEXP, SEXP noise_strengthSEXP, SEXP S_numberSEXP, SEXP num_siftingsSEXP, SEXP rng_seedSEXP, SEXP threadsSEXP) {
+NumericMatrix eemdR(NumericVector input, double num_imfs, unsigned int ensemble_size, double noise_strength, unsigned int S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads, unsigned int num_shards, int rng, bool complementary, double tolerance, int precision, int affinity, int stopping, SEXP stopping_thresholds, int interpolation, bool stats, SEXP context);
+RcppExport SEXP _Rlibeemd_eemdR(SEXP inputSEXP, SEXP num_imfsSEXP, SEXP ensemble_sizeSEXP, SEXP noise_strengthSEXP, SEXP S_numberSEXP, SEXP num_siftingsSEXP, SEXP rng_seedSEXP, SEXP threadsSEXP, SEXP num_shardsSEXP, SEXP rngSEXP, SEXP complementarySEXP, SEXP toleranceSEXP, SEXP precisionSEXP, SEXP affinitySEXP, SEXP stoppingSEXP, SEXP stopping_thresholdsSEXP, SEXP interpolationSEXP, SEXP statsSEXP, SEXP contextSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -56,7 +106,45 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< unsigned int >::type num_siftings(num_siftingsSEXP);
     Rcpp::traits::input_parameter< unsigned long int >::type rng_seed(rng_seedSEXP);
     Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
-    rcpp_result_gen = Rcpp::wrap(eemdR(input, num_imfs, ensemble_size, noise_strength, S_number, num_siftings, rng_seed, threads));
+    Rcpp::traits::input_parameter< unsigned int >::type num_shards(num_shardsSEXP);
+    Rcpp::traits::input_parameter< int >::type rng(rngSEXP);
+    Rcpp::traits::input_parameter< bool >::type complementary(complementarySEXP);
+    Rcpp::traits::input_parameter< double >::type tolerance(toleranceSEXP);
+    Rcpp::traits::input_parameter< int >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< int >::type affinity(affinitySEXP);
+    Rcpp::traits::input_parameter< int >::type stopping(stoppingSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type stopping_thresholds(stopping_thresholdsSEXP);
+    Rcpp::traits::input_parameter< int >::type interpolation(interpolationSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type context(contextSEXP);
+    rcpp_result_gen = Rcpp::wrap(eemdR(input, num_imfs, ensemble_size, noise_strength, S_number, num_siftings, rng_seed, threads, num_shards, rng, complementary, tolerance, precision, affinity, stopping, stopping_thresholds, interpolation, stats, context));
+    return rcpp_result_gen;
+END_RCPP
+}
+// eemd_batchR
+List eemd_batchR(List inputs, double num_imfs, unsigned int ensemble_size, double noise_strength, unsigned int S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads, int rng, bool complementary, double tolerance, int precision, int stopping, SEXP stopping_thresholds, int interpolation, bool stats, SEXP context);
+RcppExport SEXP _Rlibeemd_eemd_batchR(SEXP inputsSEXP, SEXP num_imfsSEXP, SEXP ensemble_sizeSEXP, SEXP noise_strengthSEXP, SEXP S_numberSEXP, SEXP num_siftingsSEXP, SEXP rng_seedSEXP, SEXP threadsSEXP, SEXP rngSEXP, SEXP complementarySEXP, SEXP toleranceSEXP, SEXP precisionSEXP, SEXP stoppingSEXP, SEXP stopping_thresholdsSEXP, SEXP interpolationSEXP, SEXP statsSEXP, SEXP contextSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< List >::type inputs(inputsSEXP);
+    Rcpp::traits::input_parameter< double >::type num_imfs(num_imfsSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type ensemble_size(ensemble_sizeSEXP);
+    Rcpp::traits::input_parameter< double >::type noise_strength(noise_strengthSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type S_number(S_numberSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type num_siftings(num_siftingsSEXP);
+    Rcpp::traits::input_parameter< unsigned long int >::type rng_seed(rng_seedSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< int >::type rng(rngSEXP);
+    Rcpp::traits::input_parameter< bool >::type complementary(complementarySEXP);
+    Rcpp::traits::input_parameter< double >::type tolerance(toleranceSEXP);
+    Rcpp::traits::input_parameter< int >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< int >::type stopping(stoppingSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type stopping_thresholds(stopping_thresholdsSEXP);
+    Rcpp::traits::input_parameter< int >::type interpolation(interpolationSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type context(contextSEXP);
+    rcpp_result_gen = Rcpp::wrap(eemd_batchR(inputs, num_imfs, ensemble_size, noise_strength, S_number, num_siftings, rng_seed, threads, rng, complementary, tolerance, precision, stopping, stopping_thresholds, interpolation, stats, context));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -71,6 +159,43 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// emd_stream_createR
+SEXP emd_stream_createR(double num_imfs, double margin, unsigned int S_number, unsigned int num_siftings);
+RcppExport SEXP _Rlibeemd_emd_stream_createR(SEXP num_imfsSEXP, SEXP marginSEXP, SEXP S_numberSEXP, SEXP num_siftingsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< double >::type num_imfs(num_imfsSEXP);
+    Rcpp::traits::input_parameter< double >::type margin(marginSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type S_number(S_numberSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type num_siftings(num_siftingsSEXP);
+    rcpp_result_gen = Rcpp::wrap(emd_stream_createR(num_imfs, margin, S_number, num_siftings));
+    return rcpp_result_gen;
+END_RCPP
+}
+// emd_stream_appendR
+NumericMatrix emd_stream_appendR(SEXP stream, NumericVector x);
+RcppExport SEXP _Rlibeemd_emd_stream_appendR(SEXP streamSEXP, SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type stream(streamSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(emd_stream_appendR(stream, x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// emd_stream_flushR
+NumericMatrix emd_stream_flushR(SEXP stream);
+RcppExport SEXP _Rlibeemd_emd_stream_flushR(SEXP streamSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type stream(streamSEXP);
+    rcpp_result_gen = Rcpp::wrap(emd_stream_flushR(stream));
+    return rcpp_result_gen;
+END_RCPP
+}
 // extremaR
 List extremaR(NumericVector x);
 RcppExport SEXP _Rlibeemd_extremaR(SEXP xSEXP) {
@@ -93,10 +218,16 @@ END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_Rlibeemd_bemdR", (DL_FUNC) &_Rlibeemd_bemdR, 4},
-    {"_Rlibeemd_ceemdanR", (DL_FUNC) &_Rlibeemd_ceemdanR, 8},
-    {"_Rlibeemd_eemdR", (DL_FUNC) &_Rlibeemd_eemdR, 8},
+    {"_Rlibeemd_bemdR", (DL_FUNC) &_Rlibeemd_bemdR, 7},
+    {"_Rlibeemd_ceemdanR", (DL_FUNC) &_Rlibeemd_ceemdanR, 17},
+    {"_Rlibeemd_ceemdan_batchR", (DL_FUNC) &_Rlibeemd_ceemdan_batchR, 17},
+    {"_Rlibeemd_emd_contextR", (DL_FUNC) &_Rlibeemd_emd_contextR, 1},
+    {"_Rlibeemd_eemdR", (DL_FUNC) &_Rlibeemd_eemdR, 19},
+    {"_Rlibeemd_eemd_batchR", (DL_FUNC) &_Rlibeemd_eemd_batchR, 17},
     {"_Rlibeemd_emd_num_imfsR", (DL_FUNC) &_Rlibeemd_emd_num_imfsR, 1},
+    {"_Rlibeemd_emd_stream_createR", (DL_FUNC) &_Rlibeemd_emd_stream_createR, 4},
+    {"_Rlibeemd_emd_stream_appendR", (DL_FUNC) &_Rlibeemd_emd_stream_appendR, 2},
+    {"_Rlibeemd_emd_stream_flushR", (DL_FUNC) &_Rlibeemd_emd_stream_flushR, 1},
     {"_Rlibeemd_extremaR", (DL_FUNC) &_Rlibeemd_extremaR, 1},
     {"_Rlibeemd_gslErrorHandlerOff", (DL_FUNC) &_Rlibeemd_gslErrorHandlerOff, 0},
     {NULL, NULL, 0}
@@ -0,0 +1,38 @@
+/*
+ ** Arena allocation of workspaces for Rlibeemd, see arena.h
+ */
+
+#include "arena.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+bool emd_arena_allocate(emd_arena* a) {
+	const size_t size = a->size;
+	const size_t alignment = (size >= EMD_ARENA_HUGE_PAGE)? EMD_ARENA_HUGE_PAGE : EMD_ARENA_ALIGNMENT;
+	// The block is aligned by hand, since aligned_alloc is not available in
+	// C99 and posix_memalign not on Windows
+	a->block = malloc(size + alignment);
+	if (a->block == NULL) {
+		return false;
+	}
+	const uintptr_t start = ((uintptr_t)a->block + alignment-1) & ~(uintptr_t)(alignment-1);
+	a->memory = (char*)start;
+	a->used = 0;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	if (alignment == EMD_ARENA_HUGE_PAGE) {
+		// Only a hint, the block works the same without huge pages
+		madvise(a->memory, size & ~(EMD_ARENA_HUGE_PAGE-1), MADV_HUGEPAGE);
+	}
+#endif
+	return true;
+}
+
+void emd_arena_free(emd_arena* a) {
+	free(a->block);
+	a->block = NULL;
+	a->memory = NULL;
+	a->size = 0;
+	a->used = 0;
+}
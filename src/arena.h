@@ -0,0 +1,65 @@
+/*
+ ** Arena allocation of workspaces for Rlibeemd:
+ ** All buffers of a workspace, and the structs themselves, are carved from
+ ** one aligned block of memory, so that a thread has a single allocation
+ ** and every buffer starts on its own cache line. The layout of a workspace
+ ** is written once, as a function taking each buffer from the arena with
+ ** emd_arena_take. The function is run twice: first on an arena from
+ ** emd_arena_sizing, where nothing is allocated and emd_arena_take returns
+ ** NULL but adds up the size of the block, and then on the arena allocated
+ ** with emd_arena_allocate.
+ */
+
+#ifndef _EEMD_ARENA_H_
+#define _EEMD_ARENA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+// Alignment of the buffers taken from an arena, the size of a cache line
+#define EMD_ARENA_ALIGNMENT 64
+
+// Blocks of at least this size are aligned to a huge page, so that the
+// operating system can back them with transparent huge pages
+#define EMD_ARENA_HUGE_PAGE ((size_t)2 << 20)
+
+typedef struct {
+	// The allocated block, or NULL if the arena is only being sized
+	void* block;
+	// Aligned start of the block
+	char* memory;
+	// Size of the block from memory onwards, and the part already taken
+	size_t size;
+	size_t used;
+} emd_arena;
+
+// Arena for adding up the size of a layout
+static inline emd_arena emd_arena_sizing(void) {
+	emd_arena a = {NULL, NULL, 0, 0};
+	return a;
+}
+
+// Take room for n elements of elem_size bytes from the arena, aligned to
+// EMD_ARENA_ALIGNMENT. Returns NULL if the arena is only being sized.
+static inline void* emd_arena_take(emd_arena* a, size_t n, size_t elem_size) {
+	const size_t bytes = (n*elem_size + EMD_ARENA_ALIGNMENT-1) & ~(size_t)(EMD_ARENA_ALIGNMENT-1);
+	void* p = (a->memory != NULL)? a->memory + a->used : NULL;
+	a->used += bytes;
+	if (a->memory == NULL) {
+		a->size = a->used;
+	}
+	return p;
+}
+
+// Allocate the block of an arena sized by running a layout on it, after
+// which the layout can be run again on the arena to take the buffers.
+// Returns false if the memory could not be allocated.
+bool emd_arena_allocate(emd_arena* a);
+
+// Free the block of an arena. Arenas that were only sized are left as they
+// are, so this can be called for workspaces carved from another arena.
+void emd_arena_free(emd_arena* a);
+
+#endif // _EEMD_ARENA_H_
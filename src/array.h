@@ -1,6 +1,7 @@
 // Changes for Rlibeemd:
 // Moved complex versions to array_complex.h
 // defined restrict as __restrict
+// Added float versions array_copy_f, array_add_f and array_sub_f
 
 /* Copyright 2013 Perttu Luukko
  
@@ -45,6 +46,11 @@ static inline void array_addmul_to(double const* src1, double const* src2, doubl
     dest[i] = src1[i] + val*src2[i];
 }
 
+static inline void array_add_squares(double const* src, size_t n, double* dest) {
+  for (size_t i=0; i<n; i++)
+    dest[i] += src[i]*src[i];
+}
+
 static inline void array_sub(double const* src, size_t n, double* dest) {
   for (size_t i=0; i<n; i++)
     dest[i] -= src[i];
@@ -55,4 +61,21 @@ static inline void array_mult(double* dest, size_t n, double val) {
     dest[i] *= val;
 }
 
+// Versions for float signals used by the single-precision sifting. Note that
+// array_add_f adds to a double array, since IMFs are always accumulated in
+// double precision.
+static inline void array_copy_f(float const* __restrict src, size_t n, float* __restrict dest) {
+  memcpy(dest, src, n*sizeof(float));
+}
+
+static inline void array_add_f(float const* src, size_t n, double* dest) {
+  for (size_t i=0; i<n; i++)
+    dest[i] += src[i];
+}
+
+static inline void array_sub_f(float const* src, size_t n, float* dest) {
+  for (size_t i=0; i<n; i++)
+    dest[i] -= src[i];
+}
+
 #endif // _EEMD_ARRAY_H_
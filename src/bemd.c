@@ -16,76 +16,122 @@
  * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "array.h"
 #include "bemd.h"
+#include "context.h"
+#include "emd.h"
+#include "error.h"
 
-bemd_sifting_workspace* allocate_bemd_sifting_workspace(size_t N, lock* output_lock) {
-  bemd_sifting_workspace* w = malloc(sizeof(bemd_sifting_workspace));
+// Layout of the BEMD workspace in its arena, as for the sifting workspaces in
+// workspace_impl.h. The lock-step workspace has an arena of its own.
+static bemd_sifting_workspace* _take_bemd_sifting_workspace(emd_arena* a, size_t N) {
+  bemd_sifting_workspace* w = emd_arena_take(a, 1, sizeof(bemd_sifting_workspace));
+  double* const envelope = emd_arena_take(a, EMD_SIFT_BLOCK, sizeof(double));
+  double* const mean_re = emd_arena_take(a, N, sizeof(double));
+  double* const mean_im = emd_arena_take(a, N, sizeof(double));
+  if (w == NULL) {
+    return NULL;
+  }
   w->N = N;
-  w->projected_signal = malloc(N*sizeof(double));
-  w->maxx = malloc(N*sizeof(double));
-  w->maxy = malloc(N*sizeof(double));
-  w->maxspline = malloc(N*sizeof(double));
-  // Spline evaluation requires 5*m-10 doubles where m is the number of
-  // extrema. The worst case scenario is that every point is an extrema, so
-  // use m=N to be safe.
-  const size_t spline_workspace_size = (N > 2)? 5*N-10 : 0;
-  w->spline_workspace = malloc(spline_workspace_size*sizeof(double));
-  w->output_lock = output_lock;
+  w->capacity = N;
+  w->envelope = envelope;
+  w->mean_re = mean_re;
+  w->mean_im = mean_im;
+  return w;
+}
+
+bemd_sifting_workspace* allocate_bemd_sifting_workspace(size_t N) {
+  lockstep_workspace* lanes = allocate_lockstep_workspace(N);
+  if (lanes == NULL) {
+    return NULL;
+  }
+  emd_arena a = emd_arena_sizing();
+  _take_bemd_sifting_workspace(&a, N);
+  if (!emd_arena_allocate(&a)) {
+    free_lockstep_workspace(lanes);
+    return NULL;
+  }
+  bemd_sifting_workspace* w = _take_bemd_sifting_workspace(&a, N);
+  w->lanes = lanes;
+  w->arena = a;
   return w;
 }
 
 void free_bemd_sifting_workspace(bemd_sifting_workspace* w) {
-  free(w->projected_signal); w->projected_signal = NULL;
-  free(w->maxx); w->maxx = NULL;
-  free(w->maxy); w->maxy = NULL;
-  free(w->maxspline); w->maxspline = NULL;
-  free(w->spline_workspace); w->spline_workspace = NULL;
-  free(w); w = NULL;
+  free_lockstep_workspace(w->lanes);
+  // The workspace itself is in the arena
+  emd_arena a = w->arena;
+  emd_arena_free(&a);
+}
+
+// Project the signal (x_re, x_im) to the num_lanes directions with unit
+// vectors (cos_phi[k], sin_phi[k]), interleaved as the lanes of lanes->x.
+// Each value of the signal is read once for all of the directions, and the
+// lanes from num_lanes onwards are zeroed.
+static void _bemd_project(double const* __restrict x_re, double const* __restrict x_im,
+  size_t N, double const* __restrict cos_phi, double const* __restrict sin_phi,
+  size_t num_lanes, lockstep_workspace* __restrict lanes) {
+  double c[EMD_LOCKSTEP_LANES];
+  double s[EMD_LOCKSTEP_LANES];
+  for (size_t k=0; k<EMD_LOCKSTEP_LANES; k++) {
+    c[k] = (k < num_lanes)? cos_phi[k] : 0;
+    s[k] = (k < num_lanes)? sin_phi[k] : 0;
+  }
+  double* const px = lanes->x;
+  for (size_t i=0; i<N; i++) {
+    const double a = x_re[i];
+    const double b = x_im[i];
+    #pragma omp simd
+    for (size_t k=0; k<EMD_LOCKSTEP_LANES; k++) {
+      px[i*EMD_LOCKSTEP_LANES+k] = a*c[k] + b*s[k];
+    }
+  }
 }
 
-// double complex* __restrict x -> Rcomplex* x
-static libeemd_error_code _bemd_sift_once(Rcomplex* x, size_t N, double const* __restrict directions, size_t num_directions, bemd_sifting_workspace* w) {
+// Add the upper envelope of x projected to each direction of this thread to
+// w->mean_re and w->mean_im, multiplied by the unit vector of the direction.
+// The directions are divided among the team of threads calling this in
+// groups of EMD_LOCKSTEP_LANES, whose projections, maxima and splines are
+// computed together, and their envelopes are added to the mean block by
+// block. cos_phi and sin_phi hold the unit vectors of all directions.
+static libeemd_error_code _bemd_envelopes(double const* x_re, double const* x_im, size_t N,
+  double const* __restrict cos_phi, double const* __restrict sin_phi, size_t num_directions,
+  libeemd_interpolation interpolation, bemd_sifting_workspace* w) {
   libeemd_error_code errcode = EMD_SUCCESS;
-  //double complex* __restrict m = calloc(N, sizeof(double complex));
-  Rcomplex* m = calloc(N, sizeof(Rcomplex));
-  double* const px = w->projected_signal;
-  // TODO: handle different directions in parallel
-  for (size_t direction_i=0; direction_i<num_directions; direction_i++) {
-    const double phi = directions[direction_i];
-    const double sin_phi = sin(phi);
-    const double cos_phi = cos(phi);
-    // Project signal
-    for (size_t i=0; i<N; i++) {
-      // const double a = creal(x[i]);
-      // const double b = cimag(x[i]);
-      const double a = x[i].r; // Rcomplex
-      const double b = x[i].i;
-      px[i] = a*cos_phi + b*sin_phi;
+  double* const m_re = w->mean_re;
+  double* const m_im = w->mean_im;
+  double* const envelope = w->envelope;
+  memset(m_re, 0x00, N*sizeof(double));
+  memset(m_im, 0x00, N*sizeof(double));
+  #pragma omp for schedule(static)
+  for (size_t group_begin=0; group_begin<num_directions; group_begin+=EMD_LOCKSTEP_LANES) {
+    if (errcode != EMD_SUCCESS) {
+      continue;
     }
-    // Find maxima
-    emd_find_maxima(px, N, w->maxx, w->maxy, &(w->num_max));
-    // Fit spline
-    errcode = emd_evaluate_spline(w->maxx, w->maxy, w->num_max, w->maxspline, w->spline_workspace);
+    const size_t num_lanes = (num_directions-group_begin < EMD_LOCKSTEP_LANES)?
+      num_directions-group_begin : EMD_LOCKSTEP_LANES;
+    double const* const c = cos_phi + group_begin;
+    double const* const s = sin_phi + group_begin;
+    _bemd_project(x_re, x_im, N, c, s, num_lanes, w->lanes);
+    // Find the maxima and fit splines or other interpolants
+    spline_cursor upper[EMD_LOCKSTEP_LANES];
+    errcode = lockstep_upper_envelopes(w->lanes, num_lanes, interpolation, upper);
     if (errcode != EMD_SUCCESS) {
-      return errcode;
+      continue;
     }
-    // Add to m
-    for (size_t i=0; i<N; i++) {
-      //m[i] += cexp(phi*I) * (w->maxspline)[i];
-      // Rcomplex
-      double amp = w->maxspline[i];
-      double re_exp = cos(phi);
-      double im_exp = sin(phi);
-      m[i].r += amp * re_exp;
-      m[i].i += amp * im_exp;
+    // Add to m in the order of the directions
+    for (size_t b=0; b<N; b+=EMD_SIFT_BLOCK) {
+      const size_t n = (N-b < EMD_SIFT_BLOCK)? N-b : EMD_SIFT_BLOCK;
+      for (size_t k=0; k<num_lanes; k++) {
+        spline_cursor_fill(&upper[k], b, n, envelope);
+        //m[i] += cexp(phi*I) * (w->maxspline)[i];
+        for (size_t p=0; p<n; p++) {
+          m_re[b+p] += envelope[p] * c[k];
+          m_im[b+p] += envelope[p] * s[k];
+        }
+      }
     }
   }
-  // Scale m
-  complex_array_mult(m, N, 2.0/(double)num_directions);
-  // Subtract mean from input
-  complex_array_sub(m, N, x);
-  // Done
-  free(m); m = NULL;
   return errcode;
 }
 
@@ -94,45 +140,175 @@ static libeemd_error_code _bemd_sift_once(Rcomplex* x, size_t N, double const* _
 libeemd_error_code bemd(const Rcomplex* input, size_t N,
   double const* __restrict directions, size_t num_directions,
   Rcomplex* output, size_t M,
-  unsigned int num_siftings) {
+  unsigned int num_siftings, libeemd_interpolation interpolation, int threads,
+  eemd_context* ctx) {
+  if (M == 0) {
+    M = emd_num_imfs(N);
+  }
+  // The input and output are split to their real and imaginary parts
+  double* const input_split = malloc(2*N*sizeof(double));
+  double* const output_split = malloc(2*N*M*sizeof(double));
+  for (size_t i=0; i<N; i++) {
+    input_split[i] = input[i].r;
+    input_split[N+i] = input[i].i;
+  }
+  libeemd_error_code bemd_err = bemd_split(input_split, input_split+N, N, directions,
+    num_directions, output_split, output_split+N*M, M, num_siftings, interpolation,
+    threads, ctx);
+  if (bemd_err == EMD_SUCCESS) {
+    for (size_t i=0; i<N*M; i++) {
+      output[i].r = output_split[i];
+      output[i].i = output_split[N*M+i];
+    }
+  }
+  free(output_split);
+  free(input_split);
+  return bemd_err;
+}
+
+libeemd_error_code bemd_split(double const* __restrict input_re,
+  double const* __restrict input_im, size_t N,
+  double const* __restrict directions, size_t num_directions,
+  double* __restrict output_re, double* __restrict output_im, size_t M,
+  unsigned int num_siftings, libeemd_interpolation interpolation, int threads,
+  eemd_context* ctx) {
   gsl_set_error_handler_off();
+  libeemd_error_code validation_result = validate_interpolation(interpolation);
+  if (validation_result != EMD_SUCCESS) {
+    return validation_result;
+  }
   if (M == 0) {
     M = emd_num_imfs(N);
   }
-  libeemd_error_code bemd_err = EMD_SUCCESS;
+  // Use a temporary context if none was given
+  eemd_context* const own_ctx = (ctx == NULL)? allocate_eemd_context() : NULL;
+  if (ctx == NULL) {
+    ctx = own_ctx;
+  }
+  // Don't start more threads than there are groups of directions
+  #ifdef _OPENMP
+  const size_t num_groups = (num_directions+EMD_LOCKSTEP_LANES-1)/EMD_LOCKSTEP_LANES;
+  int old_maxthreads = 1;
+  if (threads>0) {
+    old_maxthreads = omp_get_max_threads();
+    omp_set_num_threads(threads);
+  }
+  const size_t max_threads = (omp_get_max_threads() > (int)num_groups && num_groups > 0)?
+    num_groups : (size_t)omp_get_max_threads();
+  #else
+  const size_t max_threads = 1;
+  (void)threads;
+  #endif
+  reserve_context_bemd(ctx, N, max_threads, num_directions);
+  // The unit vectors of the directions are computed once for all siftings
+  double* const cos_phi = ctx->bemd_units;
+  double* const sin_phi = ctx->bemd_units+num_directions;
+  for (size_t direction_i=0; direction_i<num_directions; direction_i++) {
+    const double phi = directions[direction_i];
+    cos_phi[direction_i] = cos(phi);
+    sin_phi[direction_i] = sin(phi);
+  }
   // Create a read-write copy of input data
   //double complex* const x = malloc(N*sizeof(double complex));
-  Rcomplex* const x = malloc(N*sizeof(Rcomplex));
-  complex_array_copy(input, N, x);
+  double* const x_re = ctx->bemd_x;
+  double* const x_im = ctx->bemd_x+N;
+  array_copy(input_re, N, x_re);
+  array_copy(input_im, N, x_im);
   //double complex* const res = malloc(N*sizeof(double complex));
-  Rcomplex* const res = malloc(N*sizeof(Rcomplex));
+  double* const res_re = ctx->bemd_res;
+  double* const res_im = ctx->bemd_res+N;
   // For the first iteration, the residual is the original input data
-  complex_array_copy(input, N, res);
-  bemd_sifting_workspace* w = allocate_bemd_sifting_workspace(N, NULL);
-  // Loop over all IMFs to be separated from input
-  for (size_t imf_i=0; imf_i<M-1; imf_i++) {
-    if (imf_i != 0) {
-      // Except for the first iteration, restore the previous residual
-      // and use it as an input
-      complex_array_copy(res, N, x);
-    }
-    // Perform siftings on x until it is an IMF
-    for (unsigned int sift_counter=0; sift_counter<num_siftings; sift_counter++) {
-      bemd_err = _bemd_sift_once(x, N, directions, num_directions, w);
+  array_copy(input_re, N, res_re);
+  array_copy(input_im, N, res_im);
+  const double scale = 2.0/(double)num_directions;
+  // The sums of the threads are reduced in blocks, which are divided among
+  // the threads
+  const size_t block_size = 4096;
+  const size_t num_blocks = (N+block_size-1)/block_size;
+  libeemd_error_code bemd_err = EMD_SUCCESS;
+  // The same team of threads performs all siftings, each thread handling
+  // its share of the directions
+  #pragma omp parallel num_threads(max_threads)
+  {
+    #ifdef _OPENMP
+    const size_t thread_id = (size_t)omp_get_thread_num();
+    const size_t num_threads = (size_t)omp_get_num_threads();
+    #else
+    const size_t thread_id = 0;
+    const size_t num_threads = 1;
+    #endif
+    // Each thread gets its own workspace from the context
+    bemd_sifting_workspace* w = get_context_bemd_workspace(ctx, thread_id, N);
+    // Loop over all IMFs to be separated from input
+    for (size_t imf_i=0; imf_i<M-1; imf_i++) {
+      if (imf_i != 0) {
+        // Except for the first iteration, restore the previous residual
+        // and use it as an input
+        #pragma omp single
+        {
+          array_copy(res_re, N, x_re);
+          array_copy(res_im, N, x_im);
+        }
+      }
+      // Perform siftings on x until it is an IMF
+      for (unsigned int sift_counter=0; sift_counter<num_siftings; sift_counter++) {
+        const libeemd_error_code err = _bemd_envelopes(x_re, x_im, N, cos_phi, sin_phi,
+          num_directions, interpolation, w);
+        if (err != EMD_SUCCESS) {
+          #pragma omp critical (bemd_error)
+          bemd_err = err;
+        }
+        // After this barrier all threads see the same error
+        #pragma omp barrier
+        if (bemd_err != EMD_SUCCESS) {
+          break;
+        }
+        // Subtract the mean, i.e. the sum of the envelopes of all threads
+        // scaled by 2/num_directions, from x. The sums are always added in
+        // the order of the threads.
+        #pragma omp for schedule(static)
+        for (size_t block_i=0; block_i<num_blocks; block_i++) {
+          const size_t offset = block_i*block_size;
+          const size_t n = (offset+block_size < N)? block_size : N-offset;
+          double* const m_re = ctx->bemd_ws[0]->mean_re+offset;
+          double* const m_im = ctx->bemd_ws[0]->mean_im+offset;
+          for (size_t thread_i=1; thread_i<num_threads; thread_i++) {
+            array_add(ctx->bemd_ws[thread_i]->mean_re+offset, n, m_re);
+            array_add(ctx->bemd_ws[thread_i]->mean_im+offset, n, m_im);
+          }
+          for (size_t i=0; i<n; i++) {
+            x_re[offset+i] -= m_re[i]*scale;
+            x_im[offset+i] -= m_im[i]*scale;
+          }
+        }
+      }
       if (bemd_err != EMD_SUCCESS) {
-        return bemd_err;
+        break;
+      }
+      #pragma omp single
+      {
+        // Subtract this IMF from the saved copy to form the residual for
+        // the next round
+        array_sub(x_re, N, res_re);
+        array_sub(x_im, N, res_im);
+        // Write the discovered IMF to the output matrix
+        array_copy(x_re, N, output_re+N*imf_i);
+        array_copy(x_im, N, output_im+N*imf_i);
       }
     }
-    // Subtract this IMF from the saved copy to form the residual for
-    // the next round
-    complex_array_sub(x, N, res);
-    // Write the discovered IMF to the output matrix
-    complex_array_copy(x, N, output+N*imf_i);
-  }
+  } // Parallel section ends
   // Save final residual
-  complex_array_copy(res, N, output+N*(M-1));
-  free_bemd_sifting_workspace(w);
-  free(res);
-  free(x);
+  if (bemd_err == EMD_SUCCESS) {
+    array_copy(res_re, N, output_re+N*(M-1));
+    array_copy(res_im, N, output_im+N*(M-1));
+  }
+  if (own_ctx != NULL) {
+    free_eemd_context(own_ctx);
+  }
+  #ifdef _OPENMP
+  if (threads>0) {
+    omp_set_num_threads(old_maxthreads);
+  }
+  #endif
   return bemd_err;
 }
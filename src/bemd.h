@@ -1,5 +1,6 @@
 // Changes for Rlibeemd:
 // Use Rcomplex instead of _Complex
+// Added bemd_split for signals with separate real and imaginary parts
 /* Copyright 2013 Perttu Luukko
  
  * This file is part of libeemd.
@@ -18,6 +19,9 @@
  * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifndef _EEMD_BEMD_H_
+#define _EEMD_BEMD_H_
+
 #include <stddef.h>
 #include <stdlib.h>
 #include <math.h>
@@ -25,9 +29,10 @@
 #include <R_ext/Complex.h> // For Rlibeemd
 #include <gsl/gsl_errno.h>
 
+#include "arena.h"
 #include "array_complex.h" // For Rlibeemd
-#include "lock.h"
 #include "extrema.h"
+#include "lockstep.h"
 #include "spline.h"
 #include "eemd.h"
 
@@ -37,32 +42,55 @@
 //   IEEE Signal Processing Letters, vol. 14, no. 12, pp. 936-939, Dec. 2007.
 //
 // Parameters 'directions' and 'num_directions' define a vector of directions (phi_k in
-// the article) used for the decomposition. 
+// the article) used for the decomposition. The envelopes are interpolated as
+// given by interpolation, see libeemd_interpolation in eemd.h. The directions
+// are divided among 'threads' threads, or the default number of threads of
+// OpenMP if threads is zero. The final parameter is an optional persistent
+// context, see eemd_context in eemd.h.
 libeemd_error_code bemd(const Rcomplex* input, size_t N,
   double const* __restrict directions, size_t num_directions,
   Rcomplex* output, size_t M,
-  unsigned int num_siftings);
+  unsigned int num_siftings, libeemd_interpolation interpolation, int threads,
+  eemd_context* ctx);
+
+// Version of bemd for a signal stored as separate arrays of its real and
+// imaginary parts, input_re and input_im, whose IMFs are written likewise to
+// the N x M matrices output_re and output_im. bemd converts its arguments to
+// this form, which is also used for all computations.
+libeemd_error_code bemd_split(double const* __restrict input_re,
+  double const* __restrict input_im, size_t N,
+  double const* __restrict directions, size_t num_directions,
+  double* __restrict output_re, double* __restrict output_im, size_t M,
+  unsigned int num_siftings, libeemd_interpolation interpolation, int threads,
+  eemd_context* ctx);
 
-// For BEMD sifting we need arrays for storing the found maxima of the signal,
-// memory required to form the spline envelopes, and a shared lock to compute
-// different directions in parallel.
+// For BEMD sifting we need the projections of the signal, their maxima and
+// the memory required to form the spline envelopes, and the sum of the
+// envelopes of the directions handled by each thread, which are summed to
+// the mean after each sifting. The signal is projected to
+// EMD_LOCKSTEP_LANES directions at a time, which are stored and processed
+// as the lanes of a lock-step workspace, see lockstep.h.
 typedef struct {
-  // Number of samples in the signal
+  // Number of samples in the signal, and the maximum number the workspace
+  // has room for
   size_t N;
-  // Input signal projected to a particular direction in the complex plane
-  double* projected_signal;
-  // Found maxima
-  double* __restrict maxx;
-  double* __restrict maxy;
-  size_t num_max;
-  // Upper and lower envelope spline values
-  double* __restrict maxspline;
-  // Extra memory required for spline evaluation
-  double* __restrict spline_workspace;
-  // Lock
-  lock* output_lock;
+  size_t capacity;
+  // Projections of the signal to a group of directions, their maxima and
+  // the coefficients of their envelopes
+  lockstep_workspace* lanes;
+  // Values of the envelope of one direction for a block of EMD_SIFT_BLOCK
+  // samples
+  double* __restrict envelope;
+  // Real and imaginary parts of the sum of the envelopes of this thread's
+  // directions, each multiplied by the unit vector of its direction
+  double* __restrict mean_re;
+  double* __restrict mean_im;
+  // Memory of the workspace, see arena.h
+  emd_arena arena;
 } bemd_sifting_workspace;
 
-bemd_sifting_workspace* allocate_bemd_sifting_workspace(size_t N, lock* output_lock);
+bemd_sifting_workspace* allocate_bemd_sifting_workspace(size_t N);
 void free_bemd_sifting_workspace(bemd_sifting_workspace* w);
 
+#endif // _EEMD_BEMD_H_
+
@@ -3,11 +3,13 @@ extern "C"
 {
   #include "bemd.h"
 }
+#include "contextR.h"
 using namespace Rcpp;
 
 // [[Rcpp::export]]
 ComplexMatrix bemdR(ComplexVector input, NumericVector directions,
-  double num_imfs = 0, unsigned int num_siftings = 50){
+  double num_imfs = 0, unsigned int num_siftings = 50, int interpolation = 0, 
+  int threads = 0, SEXP context = R_NilValue){
   
   size_t N = input.size();
   size_t M = 0;
@@ -18,12 +20,22 @@ ComplexMatrix bemdR(ComplexVector input, NumericVector directions,
   }
   size_t D = directions.size();
   
-  ComplexMatrix output(static_cast<int>(N), static_cast<int>(M));
+  // The signal and the IMFs are split to their real and imaginary parts
+  // here once, and all computations use the split form
+  NumericVector input_re(N);
+  NumericVector input_im(N);
+  for (size_t i = 0; i < N; i++) {
+    input_re[i] = input[i].r;
+    input_im[i] = input[i].i;
+  }
+  NumericMatrix output_re(static_cast<int>(N), static_cast<int>(M));
+  NumericMatrix output_im(static_cast<int>(N), static_cast<int>(M));
   
-  libeemd_error_code err = bemd(
-    reinterpret_cast<const Rcomplex*>(input.begin()), N,
+  libeemd_error_code err = bemd_split(
+    input_re.begin(), input_im.begin(), N,
     directions.begin(), D,
-    reinterpret_cast<Rcomplex*>(output.begin()), M, num_siftings
+    output_re.begin(), output_im.begin(), M, num_siftings,
+    (libeemd_interpolation)interpolation, threads, context_pointer(context)
   );
   // 
   // libeemd_error_code err = bemd(reinterpret_cast<double _Complex const*>(input.begin()), N, 
@@ -32,5 +44,10 @@ ComplexMatrix bemdR(ComplexVector input, NumericVector directions,
   if(err!=EMD_SUCCESS){
     printError(err);
   }
+  ComplexMatrix output(static_cast<int>(N), static_cast<int>(M));
+  for (size_t i = 0; i < N*M; i++) {
+    output[i].r = output_re[i];
+    output[i].i = output_im[i];
+  }
   return output;
 }
@@ -18,43 +18,433 @@
 
 #include "ceemdan.h"
 
+// Standard deviation of the noise added to the residual res of the signal,
+// which is noise_strength times the standard deviation of res divided by the
+// standard deviation of the noise. This is used to fix the SNR at each
+// stage.
+static inline double _ceemdan_noise_sigma(double const* __restrict res,
+		double const* __restrict noise, size_t N, double noise_strength) {
+	const double noise_sd = gsl_stats_sd(noise, 1, N);
+	return (noise_sd != 0)? noise_strength*gsl_stats_sd(res, 1, N)/noise_sd : 0;
+}
+
+// Standard deviation of the noise added to the residual res for mode imf_i.
+// In the improved CEEMDAN only the first mode of the noise is normalized,
+// and the later modes are added as they are, scaled by noise_strength times
+// the standard deviation of res.
+static inline double _ceemdan_member_sigma(double const* __restrict res,
+		double const* __restrict noise, size_t N, double noise_strength, size_t imf_i,
+		bool improved) {
+	if (improved && imf_i > 0) {
+		return noise_strength*gsl_stats_sd(res, 1, N);
+	}
+	return _ceemdan_noise_sigma(res, noise, N, noise_strength);
+}
+
+// Generate the white noise of ensemble member en_i to noise. With the
+// Mersenne twister the generator is seeded based on the ensemble member to
+// ensure reproducibility even in a multithreaded case.
+static void _ceemdan_white_noise(size_t en_i, size_t N, unsigned long int rng_seed,
+		libeemd_rng rng, double* __restrict noise, eemd_workspace* w) {
+	if (rng == EMD_RNG_PHILOX) {
+		philox_gaussian(rng_seed, en_i, 0, N, 1.0, noise);
+		return;
+	}
+	set_rng_seed(w, rng_seed+en_i);
+	for (size_t j=0; j<N; j++) {
+		noise[j] = gsl_ran_gaussian(w->r, 1.0);
+	}
+}
+
+// Compute the noise of ensemble member en_i for mode imf_i to noise: the
+// white noise itself for the first mode, and mode imf_i of the white noise
+// for the others. The residual of the white noise after mode imf_i is left
+// in noise_residual. If stored is true, noise_residual already holds the
+// residual after mode imf_i-1, so only one mode of the noise is extracted.
+// Otherwise the white noise is generated again and all its modes up to
+// imf_i are extracted.
+static libeemd_error_code _ceemdan_noise(size_t en_i, size_t N, size_t imf_i, bool stored,
+		double* __restrict noise, double* __restrict noise_residual, unsigned long int rng_seed,
+		libeemd_rng rng, unsigned int S_number, unsigned int num_siftings, eemd_workspace* w) {
+	size_t first_mode = imf_i;
+	if (!stored || imf_i == 0) {
+		_ceemdan_white_noise(en_i, N, rng_seed, rng, noise_residual, w);
+		first_mode = 1;
+	}
+	if (imf_i == 0) {
+		array_copy(noise_residual, N, noise);
+		return EMD_SUCCESS;
+	}
+	for (size_t mode_i=first_mode; mode_i<=imf_i; mode_i++) {
+		array_copy(noise_residual, N, noise);
+		unsigned int sift_counter = 0;
+		libeemd_error_code sift_err = _sift(noise, w->emd_w->sift_w, S_number, num_siftings, &sift_counter);
+		if (sift_err != EMD_SUCCESS) {
+			return sift_err;
+		}
+		array_sub(noise, N, noise_residual);
+	}
+	return EMD_SUCCESS;
+}
+
+// Compute an ensemble member for mode imf_i of CEEMDAN with the given noise:
+// the residual res of the signal plus the noise is sifted, and the result is
+// added to the partial sum imf of the thread, and its square to sumsq unless
+// it is NULL. In the improved CEEMDAN the mode averages the local means of
+// the members instead: the local mean of res plus the noise is what remains
+// after sifting, so the noise is subtracted from the sifted IMF, and the
+// mean of the results is the residual res minus the mean local mean.
+static libeemd_error_code _ceemdan_member(double const* __restrict res, size_t N,
+		double const* __restrict noise, double* imf, double* sumsq, double noise_strength,
+		size_t imf_i, bool improved, unsigned int S_number, unsigned int num_siftings,
+		eemd_workspace* w) {
+	emd_thread_stats* const stats = w->stats;
+	unsigned int sift_counter = 0;
+	// Initialize input signal as data + noise
+	const double noise_sigma = _ceemdan_member_sigma(res, noise, N, noise_strength, imf_i, improved);
+	array_addmul_to(res, noise, noise_sigma, N, w->x);
+	// Sift to extract first EMD mode
+	libeemd_error_code sift_err = _sift(w->x, w->emd_w->sift_w, S_number, num_siftings, &sift_counter);
+	if (stats != NULL) {
+		record_sifting(stats, imf_i, sift_counter, w->emd_w->sift_w->num_extrema);
+	}
+	// Sum to output vector
+	const double accumulate_start = (stats != NULL)? emd_wtime() : 0;
+	if (improved) {
+		array_addmul_to(w->x, noise, -noise_sigma, N, w->x);
+	}
+	array_add(w->x, N, imf);
+	if (sumsq != NULL) {
+		array_add_squares(w->x, N, sumsq);
+	}
+	if (stats != NULL) {
+		stats->accumulate_time += emd_wtime()-accumulate_start;
+	}
+	return sift_err;
+}
+
+// Helper function for computing the CEEMDAN decomposition of a single signal
+// with an existing team of threads. It must be called by all num_threads
+// threads of the team with their own workspace w, and their own arrays
+// noises and thread_residuals of N doubles. Each thread sums its members to
+// its own part of partials, which holds partial_size doubles for each
+// thread: the partial sum of the IMF and, with an adaptive ensemble size,
+// of its squares, N doubles each. The partial sums are reduced to the
+// output after each round of members. The noise residuals of the first
+// num_stored members are kept between the modes in noise_residuals, which
+// needs room for num_stored*N doubles, and the noises of the other members
+// are generated again for each mode. The arrays res and sumsq are shared,
+// and need room for N doubles each. The current ensemble size is kept in shared_ensemble_size,
+// and the ensemble size used for the first mode is written to ensemble_used.
+// Statistics of the thread are collected to w->stats if it is set. If cache is not NULL, the noises are taken from it instead, and with
+// build_cache they are first written to it for all members and modes. With
+// improved the decomposition is the improved CEEMDAN, where mode imf_i uses
+// mode imf_i+1 of the noise and the last row of the output is only the
+// final residual. Requires M >= 2.
+static libeemd_error_code _ceemdan_team(double const* __restrict input, size_t N,
+		double* __restrict output, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed,
+		libeemd_rng rng, double tolerance, bool improved, eemd_workspace* w,
+		double* noises, double* thread_residuals, double* noise_residuals, size_t num_stored,
+		noise_cache const* cache, bool build_cache, double* res, double* sumsq,
+		double* partials, size_t partial_size, size_t thread_id, size_t num_threads,
+		libeemd_error_code* shared_err, unsigned int* shared_ensemble_size,
+		unsigned int* ensemble_used) {
+	// With an adaptive ensemble size the members of each mode are processed
+	// in rounds, and the convergence of the mode is checked after each round.
+	// Otherwise all members form a single round.
+	const bool adaptive = (tolerance > 0 && ensemble_size > 1);
+	const unsigned int round_size = adaptive? EEMD_CONVERGENCE_INTERVAL : ensemble_size;
+	const double input_sd = adaptive? gsl_stats_sd(input, 1, N) : 0;
+	emd_thread_stats* const stats = w->stats;
+	// Partial sums of this thread
+	double* const thread_imf = partials + thread_id*partial_size;
+	double* const thread_sumsq = adaptive? thread_imf+N : NULL;
+	// The partial sums are reduced in blocks, which are divided among the
+	// threads
+	const size_t block_size = 4096;
+	const size_t num_blocks = (N+block_size-1)/block_size;
+	set_eemd_workspace_length(w, N);
+	#pragma omp single
+	{
+		// Initialize output data to zero
+		memset(output, 0x00, M*N*sizeof(double));
+		// For the first iteration the residual is the input signal
+		array_copy(input, N, res);
+		*shared_err = EMD_SUCCESS;
+		*shared_ensemble_size = ensemble_size;
+		*ensemble_used = ensemble_size;
+	}
+	// All modes of the noise of a member are extracted one after another
+	// from the residual of the thread, and written to the cache
+	if (build_cache) {
+		#pragma omp for schedule(dynamic)
+		for (size_t en_i=0; en_i<ensemble_size; en_i++) {
+			#pragma omp flush
+			if (*shared_err != EMD_SUCCESS) {
+				continue;
+			}
+			const double member_start = (stats != NULL)? emd_wtime() : 0;
+			libeemd_error_code sift_err = EMD_SUCCESS;
+			for (size_t mode_i=0; mode_i<M && sift_err == EMD_SUCCESS; mode_i++) {
+				double* const mode = noise_cache_mode(cache, en_i, mode_i);
+				sift_err = _ceemdan_noise(en_i, N, mode_i, true, mode, thread_residuals, rng_seed,
+						rng, S_number, num_siftings, w);
+			}
+			if (stats != NULL) {
+				stats->busy_time += emd_wtime()-member_start;
+			}
+			if (sift_err != EMD_SUCCESS) {
+				*shared_err = sift_err;
+				#pragma omp flush
+			}
+		}
+		if (*shared_err != EMD_SUCCESS) {
+			return *shared_err;
+		}
+	}
+	// The improved CEEMDAN extracts one mode less, since the white noise
+	// itself is not used and the last row is the residual
+	const size_t num_stages = improved? M-1 : M;
+	// Each mode is extracted sequentially, but we use parallelization in the inner loop
+	// to loop over ensemble members
+	for (size_t imf_i=0; imf_i<num_stages; imf_i++) {
+		// Provide a pointer to the output vector where this IMF will be stored
+		double* const imf = &output[imf_i*N];
+		// Mode of the noise added for this mode
+		const size_t noise_i = improved? imf_i+1 : imf_i;
+		// Only the members used for the previous mode have the noise residuals
+		// needed for this one, so the ensemble can only shrink. The shared
+		// value is changed only after the barrier of the first loop below.
+		const unsigned int mode_ensemble_size = *shared_ensemble_size;
+		// The partial sums cover all rounds of the mode. No other thread
+		// reads them before the barrier of the first loop below.
+		memset(thread_imf, 0x00, N*sizeof(double));
+		if (adaptive) {
+			memset(thread_sumsq, 0x00, N*sizeof(double));
+		}
+		for (size_t en_begin=0; en_begin<mode_ensemble_size; en_begin+=round_size) {
+			const size_t en_end = (en_begin+round_size < mode_ensemble_size)? en_begin+round_size : mode_ensemble_size;
+			// The cost of the members whose noise is generated again grows
+			// with the mode, so the members are handed out dynamically
+			#pragma omp for schedule(dynamic)
+			for (size_t en_i=en_begin; en_i<en_end; en_i++) {
+				// Check if an error has occured in other threads
+				#pragma omp flush
+				if (*shared_err != EMD_SUCCESS) {
+					continue;
+				}
+				const double member_start = (stats != NULL)? emd_wtime() : 0;
+				double* member_noise = noises;
+				libeemd_error_code sift_err = EMD_SUCCESS;
+				if (cache != NULL) {
+					member_noise = noise_cache_mode(cache, en_i, noise_i);
+				}
+				else {
+					// The noise residual of this member is either stored or
+					// computed again in the array of the thread. Nothing is
+					// stored yet for the first mode.
+					const bool kept = (en_i < num_stored);
+					const bool stored = kept && imf_i > 0;
+					double* const noise_residual = kept? &noise_residuals[N*en_i] : thread_residuals;
+					sift_err = _ceemdan_noise(en_i, N, noise_i, stored, noises, noise_residual, rng_seed,
+							rng, S_number, num_siftings, w);
+				}
+				if (sift_err == EMD_SUCCESS) {
+					sift_err = _ceemdan_member(res, N, member_noise, thread_imf, thread_sumsq, noise_strength,
+							imf_i, improved, S_number, num_siftings, w);
+				}
+				if (stats != NULL) {
+					stats->busy_time += emd_wtime()-member_start;
+				}
+				if (sift_err != EMD_SUCCESS) {
+					*shared_err = sift_err;
+					#pragma omp flush
+				}
+			}
+			// The implicit barrier at the end of the loop makes the error visible
+			// to all threads, so that they all return here
+			if (*shared_err != EMD_SUCCESS) {
+				return *shared_err;
+			}
+			// Sum the partial sums of the threads to imf and sumsq, always in
+			// the order of the threads
+			const double reduce_start = (stats != NULL)? emd_wtime() : 0;
+			#pragma omp for schedule(static)
+			for (size_t block_i=0; block_i<num_blocks; block_i++) {
+				const size_t offset = block_i*block_size;
+				const size_t n = (offset+block_size < N)? block_size : N-offset;
+				array_copy(partials+offset, n, imf+offset);
+				for (size_t thread_i=1; thread_i<num_threads; thread_i++) {
+					array_add(partials+thread_i*partial_size+offset, n, imf+offset);
+				}
+				if (adaptive) {
+					array_copy(partials+N+offset, n, sumsq+offset);
+					for (size_t thread_i=1; thread_i<num_threads; thread_i++) {
+						array_add(partials+thread_i*partial_size+N+offset, n, sumsq+offset);
+					}
+				}
+			}
+			if (stats != NULL) {
+				const double reduce_time = emd_wtime()-reduce_start;
+				stats->accumulate_time += reduce_time;
+				stats->busy_time += reduce_time;
+			}
+			#pragma omp single
+			{
+				if (en_end == mode_ensemble_size || ensemble_converged(imf, sumsq, N, 1,
+							en_end, 1, tolerance, input_sd)) {
+					*shared_ensemble_size = (unsigned int)en_end;
+					if (imf_i == 0) {
+						*ensemble_used = (unsigned int)en_end;
+					}
+					// Divide with ensemble size to get the average
+					array_mult(imf, N, 1.0/en_end);
+					// Subtract this IMF from the previous residual to form the new one
+					array_sub(imf, N, res);
+				}
+			}
+			// All threads see the value set above, since it can only change
+			// again after the next barrier
+			if (*shared_ensemble_size == en_end) {
+				break;
+			}
+		}
+	}
+	// Save final residual
+	#pragma omp single
+	{
+		array_add(res, N, output+N*(M-1));
+	}
+	return EMD_SUCCESS;
+}
+
+static libeemd_error_code _ceemdan_batch(double const* const* inputs, size_t const* N,
+		size_t num_series, double* const* outputs, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads,
+		libeemd_rng rng, double tolerance, unsigned int* ensemble_used,
+		emd_stopping const* stopping, libeemd_interpolation interpolation,
+		size_t memory_limit, emd_stats* stats, eemd_context* ctx,
+		bool improved);
+
 // Main CEEMDAN decomposition routine definition
 libeemd_error_code ceemdan(double const* __restrict input, size_t N,
 		double* __restrict output, size_t M,
 		unsigned int ensemble_size, double noise_strength, unsigned int
-		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads) {
+		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads,
+		libeemd_rng rng, double tolerance, unsigned int* ensemble_used,
+		emd_stopping const* stopping, libeemd_interpolation interpolation,
+		size_t memory_limit, emd_stats* stats, eemd_context* ctx) {
+	// A single series is just a batch of one
+	double const* inputs[1] = { input };
+	double* outputs[1] = { output };
+	return ceemdan_batch(inputs, &N, 1, outputs, M, ensemble_size,
+			noise_strength, S_number, num_siftings, rng_seed, threads, rng,
+			tolerance, ensemble_used, stopping, interpolation, memory_limit, stats, ctx);
+}
+
+// Batched CEEMDAN routine definition
+libeemd_error_code ceemdan_batch(double const* const* inputs, size_t const* N,
+		size_t num_series, double* const* outputs, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads,
+		libeemd_rng rng, double tolerance, unsigned int* ensemble_used,
+		emd_stopping const* stopping, libeemd_interpolation interpolation,
+		size_t memory_limit, emd_stats* stats, eemd_context* ctx) {
+	return _ceemdan_batch(inputs, N, num_series, outputs, M, ensemble_size,
+			noise_strength, S_number, num_siftings, rng_seed, threads, rng,
+			tolerance, ensemble_used, stopping, interpolation, memory_limit, stats, ctx,
+			false);
+}
+
+// Improved CEEMDAN decomposition routine definition
+libeemd_error_code iceemdan(double const* __restrict input, size_t N,
+		double* __restrict output, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads,
+		libeemd_rng rng, double tolerance, unsigned int* ensemble_used,
+		emd_stopping const* stopping, libeemd_interpolation interpolation,
+		size_t memory_limit, emd_stats* stats, eemd_context* ctx) {
+	double const* inputs[1] = { input };
+	double* outputs[1] = { output };
+	return iceemdan_batch(inputs, &N, 1, outputs, M, ensemble_size,
+			noise_strength, S_number, num_siftings, rng_seed, threads, rng,
+			tolerance, ensemble_used, stopping, interpolation, memory_limit, stats, ctx);
+}
+
+// Batched improved CEEMDAN routine definition
+libeemd_error_code iceemdan_batch(double const* const* inputs, size_t const* N,
+		size_t num_series, double* const* outputs, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads,
+		libeemd_rng rng, double tolerance, unsigned int* ensemble_used,
+		emd_stopping const* stopping, libeemd_interpolation interpolation,
+		size_t memory_limit, emd_stats* stats, eemd_context* ctx) {
+	return _ceemdan_batch(inputs, N, num_series, outputs, M, ensemble_size,
+			noise_strength, S_number, num_siftings, rng_seed, threads, rng,
+			tolerance, ensemble_used, stopping, interpolation, memory_limit, stats, ctx,
+			true);
+}
+
+// Both variants share the same team of threads and buffers, and differ only
+// in the modes of the noise used and in what is averaged over the ensemble
+static libeemd_error_code _ceemdan_batch(double const* const* inputs, size_t const* N,
+		size_t num_series, double* const* outputs, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads,
+		libeemd_rng rng, double tolerance, unsigned int* ensemble_used,
+		emd_stopping const* stopping, libeemd_interpolation interpolation,
+		size_t memory_limit, emd_stats* stats, eemd_context* ctx,
+		bool improved) {
 	gsl_set_error_handler_off();
 	// Validate parameters
-	libeemd_error_code validation_result = validate_eemd_parameters(ensemble_size, noise_strength, S_number, num_siftings);
+	libeemd_error_code validation_result = validate_eemd_parameters(ensemble_size, noise_strength, S_number, num_siftings, stopping);
+	if (validation_result == EMD_SUCCESS) {
+		validation_result = validate_rng(rng);
+	}
+	if (validation_result == EMD_SUCCESS) {
+		validation_result = validate_stopping(stopping);
+	}
+	if (validation_result == EMD_SUCCESS) {
+		validation_result = validate_interpolation(interpolation);
+	}
 	if (validation_result != EMD_SUCCESS) {
 		return validation_result;
 	}
+	if (ensemble_used != NULL) {
+		for (size_t series_i=0; series_i<num_series; series_i++) {
+			ensemble_used[series_i] = ensemble_size;
+		}
+	}
+	// The shared arrays and workspaces are allocated for the longest series
+	// and reused for all the others
+	size_t max_N = 0;
+	for (size_t series_i=0; series_i<num_series; series_i++) {
+		if (N[series_i] > max_N) {
+			max_N = N[series_i];
+		}
+	}
 	// For empty data we have nothing to do
-	if (N == 0) {
+	if (max_N == 0) {
 		return EMD_SUCCESS;
 	}
-	// For M == 1 the only "IMF" is the residual
-	if (M == 1) {
-		memcpy(output, input, N*sizeof(double));
-		return EMD_SUCCESS;
+	// Use a temporary context if none was given
+	eemd_context* const own_ctx = (ctx == NULL)? allocate_eemd_context() : NULL;
+	if (ctx == NULL) {
+		ctx = own_ctx;
 	}
-	if (M == 0) {
-		M = emd_num_imfs(N);
+	// Sums of squares of the current mode for an adaptive ensemble size
+	double* const sumsq = (tolerance > 0)? get_context_sumsq(ctx, max_N) : NULL;
+	// Since we need to decompose the noise of each member by EMD, the
+	// residuals of the noises are kept between the modes for as many members
+	// as fit in memory_limit. The noises of the other members are generated
+	// and decomposed again for each mode.
+	size_t num_stored = memory_limit/(max_N*sizeof(double));
+	if (num_stored > ensemble_size) {
+		num_stored = ensemble_size;
 	}
-	const double one_per_ensemble_size = 1.0/ensemble_size;
-	// Initialize output data to zero
-	memset(output, 0x00, M*N*sizeof(double));
-	// Each thread gets a separate workspace if we are using OpenMP
-	eemd_workspace** ws = NULL;
-	// All threads need to write to the same row of the output matrix
-	// so we need only one shared lock
-	lock* output_lock = malloc(sizeof(lock));
-	init_lock(output_lock);
-	// The threads also share the same precomputed noise
-	double* noises = malloc(ensemble_size*N*sizeof(double));
-	// Since we need to decompose this noise by EMD, we also need arrays for storing
-	// the residuals
-	double* noise_residuals = malloc(ensemble_size*N*sizeof(double));
 	// Don't start unnecessary threads if the ensemble is small
 	#ifdef _OPENMP
 	int old_maxthreads = 1;
@@ -65,127 +455,136 @@ libeemd_error_code ceemdan(double const* __restrict input, size_t N,
 	if (omp_get_num_threads() > (int)ensemble_size) {
 	  omp_set_num_threads((int)ensemble_size);
 	}
+	// Each thread gets a separate workspace if we are using OpenMP
+	const size_t max_threads = (size_t)omp_get_max_threads();
+	#else
+	const size_t max_threads = 1;
+	(void)threads;
 	#endif
-	size_t num_threads;
-	// The following section is executed in parallel
+	reserve_context_threads(ctx, max_threads);
+	// Each thread has arrays for the noises of its members and for the
+	// residuals of the noises that are not stored. Finally there is the
+	// residual of the signal shared among all threads.
+	const size_t thread_noises_size = 2*max_N;
+	reserve_context_noises(ctx, max_threads*thread_noises_size, num_stored*max_N, max_N);
+	double* const noises = ctx->noises;
+	double* const noise_residuals = ctx->noise_residuals;
+	double* const res = ctx->res;
+	// Instead of adding its members to the shared row of the output under a
+	// lock, each thread sums them privately, and the sums are reduced after
+	// each round
+	const size_t partial_size = ((tolerance > 0)? 2 : 1)*max_N;
+	double* const partials = get_context_member_outputs(ctx, max_threads*partial_size);
+	// Each thread collects its own statistics if they were requested. The
+	// longest series has the most IMFs.
+	const size_t max_M = (M == 0)? emd_num_imfs(max_N) : M;
+	emd_thread_stats* const thread_stats = (stats != NULL)? allocate_thread_stats(max_threads, max_M) : NULL;
+	size_t team_size = 1;
+	const double start_time = emd_wtime();
+	libeemd_error_code ceemdan_err = EMD_SUCCESS;
+	libeemd_error_code shared_err = EMD_SUCCESS;
+	unsigned int shared_ensemble_size = ensemble_size;
+	unsigned int series_ensemble_used = ensemble_size;
+	// Noise modes of the current length from the cache of the context, and
+	// whether they are being written for the current series
+	noise_cache cache = noise_cache_init();
+	bool build_cache = false;
+	// The following section is executed in parallel. The same team of threads
+	// decomposes all series one after another.
 	#pragma omp parallel
 	{
 		#ifdef _OPENMP
-	  num_threads = (size_t)omp_get_num_threads();
 	  const size_t thread_id = (size_t)omp_get_thread_num();
+		#pragma omp master
+		team_size = (size_t)omp_get_num_threads();
 		#if EEMD_DEBUG >= 1
 		#pragma omp single
-		REprintf("Using %d thread(s) with OpenMP.\n", num_threads);
+		REprintf("Using %d thread(s) with OpenMP.\n", omp_get_num_threads());
 		#endif
+		const size_t num_threads = (size_t)omp_get_num_threads();
 		#else
-		num_threads = 1;
 		const size_t thread_id = 0;
+		const size_t num_threads = 1;
 		#endif
-		#pragma omp single
-		{
-			ws = malloc(num_threads*sizeof(eemd_workspace*));
-		}
-		// Each thread allocates its own workspace
-		ws[thread_id] = allocate_eemd_workspace(N);
-		eemd_workspace* w = ws[thread_id];
-		// Precompute and store white noise, since for each mode of the data we
-		// need the same mode of the corresponding realization of noise
-		#pragma omp for
-		for (size_t en_i=0; en_i<ensemble_size; en_i++) {
-			// set rng seed based on ensemble member to ensure
-			// reproducibility even in a multithreaded case
-			set_rng_seed(w, rng_seed+en_i);
-			for (size_t j=0; j<N; j++) {
-				noises[N*en_i+j] = gsl_ran_gaussian(w->r, 1.0);
+		// Each thread gets its own workspace from the context
+		eemd_workspace* w = get_context_workspace(ctx, thread_id, max_N, EMD_DOUBLE);
+		double* const thread_noises = noises + thread_id*thread_noises_size;
+		set_eemd_workspace_stats(w, (thread_stats != NULL)? &thread_stats[thread_id] : NULL);
+		set_eemd_workspace_stopping(w, stopping);
+		set_eemd_workspace_interpolation(w, interpolation);
+		for (size_t series_i=0; series_i<num_series; series_i++) {
+			// The value of ceemdan_err is only changed inside single
+			// constructs, so all threads see the same value here
+			if (ceemdan_err != EMD_SUCCESS) {
+				break;
 			}
-		}
-	} // Return to sequental mode
-	// Allocate memory for the residual shared among all threads
-	double* __restrict res = malloc(N*sizeof(double));
-	// For the first iteration the residual is the input signal
-	array_copy(input, N, res);
-	// Each mode is extracted sequentially, but we use parallelization in the inner loop
-	// to loop over ensemble members
-	for (size_t imf_i=0; imf_i<M; imf_i++) {
-		// Provide a pointer to the output vector where this IMF will be stored
-		double* const imf = &output[imf_i*N];
-		// Then we go parallel to compute the different ensemble members
-		libeemd_error_code sift_err = EMD_SUCCESS;
-		#pragma omp parallel
-		{
-			#ifdef _OPENMP
-			const int thread_id = omp_get_thread_num();
-			#else
-			const int thread_id = 0;
-			#endif
-			eemd_workspace* w = ws[thread_id];
-			unsigned int sift_counter = 0;
-			#pragma omp for
-			for (size_t en_i=0; en_i<ensemble_size; en_i++) {
-				// Check if an error has occured in other threads
-				#pragma omp flush(sift_err)
-				if (sift_err != EMD_SUCCESS) {
-					continue;
+			const size_t N_i = N[series_i];
+			// For empty data we have nothing to do
+			if (N_i == 0) {
+				continue;
+			}
+			const size_t M_i = (M == 0)? emd_num_imfs(N_i) : M;
+			// For M == 1 the only "IMF" is the residual
+			if (M_i == 1) {
+				#pragma omp single
+				memcpy(outputs[series_i], inputs[series_i], N_i*sizeof(double));
+				continue;
+			}
+			// The modes mapped for the previous series are reused if they fit,
+			// since the other parameters of the key are the same for all series
+			#pragma omp single
+			{
+				build_cache = false;
+				if (ctx->noise_cache_dir != NULL && !(cache.modes != NULL && cache.N == N_i
+							&& cache.num_modes >= M_i)) {
+					noise_cache_close(&cache);
+					const noise_cache_key key = noise_cache_make_key(N_i, rng_seed, rng, S_number,
+							num_siftings, stopping, interpolation);
+					if (!noise_cache_open(&cache, ctx->noise_cache_dir, &key, ensemble_size, M_i)) {
+						build_cache = noise_cache_create(&cache, ctx->noise_cache_dir, &key,
+								ensemble_size, M_i);
+					}
 				}
-				// Provide a pointer to the noise vector and noise residual used by
-				// this ensemble member
-				double* const noise = &noises[N*en_i];
-				double* const noise_residual = &noise_residuals[N*en_i];
-				// Initialize input signal as data + noise.
-				// The noise standard deviation is noise_strength times the
-				// standard deviation of input data divided by the standard
-				// deviation of the noise. This is used to fix the SNR at each
-				// stage.
-				const double noise_sd = gsl_stats_sd(noise, 1, N);
-				const double noise_sigma = (noise_sd != 0)? noise_strength*gsl_stats_sd(res, 1, N)/noise_sd : 0;
-				array_addmul_to(res, noise, noise_sigma, N, w->x);
-				// Sift to extract first EMD mode
-				sift_err = _sift(w->x, w->emd_w->sift_w, S_number, num_siftings, &sift_counter);
-				#pragma omp flush(sift_err)
-				// Sum to output vector
-				get_lock(output_lock);
-				array_add(w->x, N, imf);
-				release_lock(output_lock);
-				// Extract next EMD mode of the noise. This is used as the noise for
-				// the next mode extracted from the data
-				if (imf_i == 0) {
-					array_copy(noise, N, noise_residual);
+			}
+			libeemd_error_code err = _ceemdan_team(inputs[series_i], N_i,
+					outputs[series_i], M_i, ensemble_size, noise_strength,
+					S_number, num_siftings, rng_seed, rng, tolerance, improved, w, thread_noises,
+					thread_noises+max_N, noise_residuals, num_stored,
+					(cache.modes != NULL)? &cache : NULL, build_cache, res, sumsq, partials,
+					partial_size, thread_id, num_threads, &shared_err,
+					&shared_ensemble_size, &series_ensemble_used);
+			#pragma omp single
+			{
+				ceemdan_err = err;
+				// A file whose modes were not all written is removed
+				if (build_cache) {
+					if (err == EMD_SUCCESS) {
+						noise_cache_commit(&cache);
+					}
+					else {
+						noise_cache_close(&cache);
+					}
 				}
-				else {
-					array_copy(noise_residual, N, noise);
+				if (ensemble_used != NULL) {
+					ensemble_used[series_i] = series_ensemble_used;
 				}
-				sift_err = _sift(noise, w->emd_w->sift_w, S_number, num_siftings, &sift_counter);
-				#pragma omp flush(sift_err)
-				array_sub(noise, N, noise_residual);
 			}
-		} // Parallel section ends
-		if (sift_err != EMD_SUCCESS) {
-			return sift_err;
 		}
-		// Divide with ensemble size to get the average
-		array_mult(imf, N, one_per_ensemble_size);
-		// Subtract this IMF from the previous residual to form the new one
-		array_sub(imf, N, res);
+	} // Parallel section ends
+	noise_cache_close(&cache);
+	if (stats != NULL) {
+		collect_emd_stats(stats, thread_stats, team_size, emd_wtime()-start_time);
+		free_thread_stats(thread_stats, max_threads);
 	}
-	// Save final residual
-	get_lock(output_lock);
-	array_add(res, N, output+N*(M-1));
-	release_lock(output_lock);
 	// Free global resources
-	for (size_t thread_id=0; thread_id<num_threads; thread_id++) {
-		free_eemd_workspace(ws[thread_id]);
-	}
-	free(ws); ws = NULL;
-	free(res); res = NULL;
-	free(noise_residuals); noise_residuals = NULL;
-	free(noises); noises = NULL;
-	destroy_lock(output_lock);
-	free(output_lock); output_lock = NULL;
+	if (own_ctx != NULL) {
+		free_eemd_context(own_ctx);
+	}
 	
 #ifdef _OPENMP
 	if (threads>0) {
 	  omp_set_num_threads(old_maxthreads);    
 	}
 #endif
-	return EMD_SUCCESS;
+	return ceemdan_err;
 }
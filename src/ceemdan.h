@@ -28,5 +28,9 @@
 #include "error.h"
 #include "workspace.h"
 #include "emd.h"
+#include "context.h"
+#include "philox.h"
+#include "convergence.h"
+#include "noise_cache.h"
 
 #endif // _EEMD_CEEMDAN_H_
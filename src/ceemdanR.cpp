@@ -4,13 +4,27 @@ extern "C"
 {
   #include "eemd.h"
 }
+#include "contextR.h"
+#include "statsR.h"
+#include "stoppingR.h"
 
 using namespace Rcpp;
 
+// Memory limit of the noise residuals in bytes, where a negative value
+// means no limit
+static size_t noise_memory_limit(double memory_limit) {
+  if (memory_limit < 0 || memory_limit >= (double)SIZE_MAX) {
+    return SIZE_MAX;
+  }
+  return (size_t)memory_limit;
+}
+
 // [[Rcpp::export]]
 NumericMatrix ceemdanR(NumericVector input, double num_imfs=0, unsigned int ensemble_size=250, 
 double noise_strength=0.2, unsigned int S_number=4, unsigned int num_siftings=50, 
-unsigned long int rng_seed=0, int threads=0){ 
+unsigned long int rng_seed=0, int threads=0, int rng=0, double tolerance=0, 
+int stopping=0, SEXP stopping_thresholds=R_NilValue, int interpolation=0, double memory_limit=-1, bool stats=false, 
+SEXP context=R_NilValue, bool improved=false){ 
   
   size_t N = input.size();
   size_t M = 0;
@@ -20,13 +34,64 @@ unsigned long int rng_seed=0, int threads=0){
     M = (size_t)num_imfs;
   }
   NumericMatrix output(static_cast<int>(N), static_cast<int>(M));
-  libeemd_error_code err = ceemdan(input.begin(), N, output.begin(), M, ensemble_size, 
-    noise_strength, S_number, num_siftings, rng_seed, threads);
+  unsigned int ensemble_used = ensemble_size;
+  emd_stats* emd_stats_ptr = stats ? allocate_emd_stats() : NULL;
+  emd_stopping criterion;
+  libeemd_error_code err = (improved ? iceemdan : ceemdan)(input.begin(), N, output.begin(), M, ensemble_size, 
+    noise_strength, S_number, num_siftings, rng_seed, threads, (libeemd_rng)rng, 
+    tolerance, &ensemble_used, stopping_criterion(stopping, stopping_thresholds, &criterion),
+    (libeemd_interpolation)interpolation, noise_memory_limit(memory_limit), emd_stats_ptr, context_pointer(context));
   
 
   
+  RObject stats_output = stats_list(emd_stats_ptr);
   if(err!=EMD_SUCCESS){
     printError(err);
   }
+  output.attr("ensemble_size") = static_cast<int>(ensemble_used);
+  output.attr("stats") = stats_output;
   return output;
 }
+
+// [[Rcpp::export]]
+List ceemdan_batchR(List inputs, double num_imfs=0, unsigned int ensemble_size=250, 
+double noise_strength=0.2, unsigned int S_number=4, unsigned int num_siftings=50, 
+unsigned long int rng_seed=0, int threads=0, int rng=0, double tolerance=0, 
+int stopping=0, SEXP stopping_thresholds=R_NilValue, int interpolation=0, double memory_limit=-1, bool stats=false, 
+SEXP context=R_NilValue, bool improved=false){ 
+  
+  size_t num_series = inputs.size();
+  std::vector<NumericVector> x(num_series);
+  std::vector<size_t> N(num_series);
+  std::vector<double const*> input_ptrs(num_series);
+  std::vector<double*> output_ptrs(num_series);
+  std::vector<unsigned int> ensemble_used(num_series, ensemble_size);
+  List outputs(num_series);
+  emd_stats* emd_stats_ptr = stats ? allocate_emd_stats() : NULL;
+  emd_stopping criterion;
+  for (size_t i = 0; i < num_series; i++) {
+    x[i] = as<NumericVector>(inputs[i]);
+    N[i] = x[i].size();
+    size_t M = (num_imfs==0) ? emd_num_imfs(N[i]) : (size_t)num_imfs;
+    NumericMatrix output(static_cast<int>(N[i]), static_cast<int>(M));
+    input_ptrs[i] = x[i].begin();
+    output_ptrs[i] = output.begin();
+    outputs[i] = output;
+  }
+  libeemd_error_code err = (improved ? iceemdan_batch : ceemdan_batch)(input_ptrs.data(), N.data(), num_series,
+    output_ptrs.data(), (size_t)num_imfs, ensemble_size, noise_strength, 
+    S_number, num_siftings, rng_seed, threads, (libeemd_rng)rng, 
+    tolerance, ensemble_used.data(), 
+    stopping_criterion(stopping, stopping_thresholds, &criterion), 
+    (libeemd_interpolation)interpolation, noise_memory_limit(memory_limit), emd_stats_ptr, context_pointer(context));
+  
+  RObject stats_output = stats_list(emd_stats_ptr);
+  if(err!=EMD_SUCCESS){
+    printError(err);
+  }
+  for (size_t i = 0; i < num_series; i++) {
+    as<NumericMatrix>(outputs[i]).attr("ensemble_size") = static_cast<int>(ensemble_used[i]);
+  }
+  outputs.attr("stats") = stats_output;
+  return outputs;
+}
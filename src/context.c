@@ -0,0 +1,201 @@
+/*
+ ** Persistent decomposition context for Rlibeemd, see context.h
+ */
+
+#include <string.h>
+#include <sys/stat.h>
+
+#include "context.h"
+
+// Grow buffer *buf of *size doubles to at least new_size doubles. The
+// contents are not preserved.
+static double* _grow_buffer(double** buf, size_t* size, size_t new_size) {
+	if (new_size > *size) {
+		free(*buf);
+		*buf = malloc(new_size*sizeof(double));
+		*size = new_size;
+	}
+	return *buf;
+}
+
+eemd_context* allocate_eemd_context(void) {
+	eemd_context* ctx = malloc(sizeof(eemd_context));
+	ctx->num_workspaces = 0;
+	ctx->ws = NULL;
+	ctx->num_locks = 0;
+	ctx->locks = NULL;
+	ctx->shard_outputs_size = 0;
+	ctx->shard_outputs = NULL;
+	ctx->domain_outputs_size = 0;
+	ctx->domain_outputs = NULL;
+	ctx->member_outputs_size = 0;
+	ctx->member_outputs = NULL;
+	ctx->sumsq_size = 0;
+	ctx->sumsq = NULL;
+	ctx->noises_size = 0;
+	ctx->noises = NULL;
+	ctx->noise_residuals_size = 0;
+	ctx->noise_residuals = NULL;
+	ctx->res_size = 0;
+	ctx->res = NULL;
+	ctx->num_bemd_workspaces = 0;
+	ctx->bemd_ws = NULL;
+	ctx->bemd_capacity = 0;
+	ctx->bemd_x = NULL;
+	ctx->bemd_res = NULL;
+	ctx->bemd_units_size = 0;
+	ctx->bemd_units = NULL;
+	ctx->noise_cache_dir = NULL;
+	return ctx;
+}
+
+void free_eemd_context(eemd_context* ctx) {
+	free(ctx->noise_cache_dir); ctx->noise_cache_dir = NULL;
+	free(ctx->bemd_units); ctx->bemd_units = NULL;
+	free(ctx->bemd_res); ctx->bemd_res = NULL;
+	free(ctx->bemd_x); ctx->bemd_x = NULL;
+	free(ctx->res); ctx->res = NULL;
+	free(ctx->noise_residuals); ctx->noise_residuals = NULL;
+	free(ctx->noises); ctx->noises = NULL;
+	free(ctx->sumsq); ctx->sumsq = NULL;
+	free(ctx->member_outputs); ctx->member_outputs = NULL;
+	free(ctx->domain_outputs); ctx->domain_outputs = NULL;
+	free(ctx->shard_outputs); ctx->shard_outputs = NULL;
+	for (size_t i=0; i<ctx->num_locks; i++) {
+		destroy_lock(ctx->locks[i]);
+		free(ctx->locks[i]);
+	}
+	free(ctx->locks); ctx->locks = NULL;
+	for (size_t i=0; i<ctx->num_workspaces; i++) {
+		if (ctx->ws[i] != NULL) {
+			free_eemd_workspace(ctx->ws[i]);
+		}
+	}
+	free(ctx->ws); ctx->ws = NULL;
+	for (size_t i=0; i<ctx->num_bemd_workspaces; i++) {
+		if (ctx->bemd_ws[i] != NULL) {
+			free_bemd_sifting_workspace(ctx->bemd_ws[i]);
+		}
+	}
+	free(ctx->bemd_ws); ctx->bemd_ws = NULL;
+	free(ctx); ctx = NULL;
+}
+
+libeemd_error_code set_eemd_context_noise_cache(eemd_context* ctx, char const* directory) {
+	if (directory != NULL) {
+		struct stat st;
+		if (stat(directory, &st) != 0 || !S_ISDIR(st.st_mode)) {
+			return EMD_INVALID_NOISE_CACHE;
+		}
+	}
+	free(ctx->noise_cache_dir);
+	ctx->noise_cache_dir = NULL;
+	if (directory != NULL) {
+		ctx->noise_cache_dir = malloc(strlen(directory)+1);
+		strcpy(ctx->noise_cache_dir, directory);
+	}
+	return EMD_SUCCESS;
+}
+
+void reserve_context_threads(eemd_context* ctx, size_t num_threads) {
+	if (num_threads <= ctx->num_workspaces) {
+		return;
+	}
+	ctx->ws = realloc(ctx->ws, num_threads*sizeof(eemd_workspace*));
+	for (size_t i=ctx->num_workspaces; i<num_threads; i++) {
+		ctx->ws[i] = NULL;
+	}
+	ctx->num_workspaces = num_threads;
+}
+
+eemd_workspace* get_context_workspace(eemd_context* ctx, size_t thread_id, size_t N,
+		libeemd_precision precision) {
+	eemd_workspace* w = ctx->ws[thread_id];
+	if (w == NULL || w->capacity < N || w->precision != precision) {
+		if (w != NULL) {
+			free_eemd_workspace(w);
+		}
+		w = allocate_eemd_workspace(N, precision);
+		ctx->ws[thread_id] = w;
+	}
+	set_eemd_workspace_length(w, N);
+	// Statistics are only collected if the calling routine asks for them,
+	// and the S-number is used unless another criterion is given
+	set_eemd_workspace_stats(w, NULL);
+	set_eemd_workspace_stopping(w, NULL);
+	set_eemd_workspace_interpolation(w, EMD_INTERP_SPLINE);
+	return w;
+}
+
+lock** get_context_locks(eemd_context* ctx, size_t num_locks) {
+	if (num_locks > ctx->num_locks) {
+		ctx->locks = realloc(ctx->locks, num_locks*sizeof(lock*));
+		for (size_t i=ctx->num_locks; i<num_locks; i++) {
+			ctx->locks[i] = malloc(sizeof(lock));
+			init_lock(ctx->locks[i]);
+		}
+		ctx->num_locks = num_locks;
+	}
+	return ctx->locks;
+}
+
+double* get_context_shard_outputs(eemd_context* ctx, size_t size) {
+	return _grow_buffer(&ctx->shard_outputs, &ctx->shard_outputs_size, size);
+}
+
+double* get_context_domain_outputs(eemd_context* ctx, size_t size) {
+	return _grow_buffer(&ctx->domain_outputs, &ctx->domain_outputs_size, size);
+}
+
+double* get_context_member_outputs(eemd_context* ctx, size_t size) {
+	return _grow_buffer(&ctx->member_outputs, &ctx->member_outputs_size, size);
+}
+
+double* get_context_sumsq(eemd_context* ctx, size_t size) {
+	return _grow_buffer(&ctx->sumsq, &ctx->sumsq_size, size);
+}
+
+void reserve_context_noises(eemd_context* ctx, size_t noises_size, size_t residuals_size,
+		size_t res_size) {
+	_grow_buffer(&ctx->noises, &ctx->noises_size, noises_size);
+	_grow_buffer(&ctx->noise_residuals, &ctx->noise_residuals_size, residuals_size);
+	_grow_buffer(&ctx->res, &ctx->res_size, res_size);
+}
+
+void reserve_context_bemd(eemd_context* ctx, size_t N, size_t num_threads,
+		size_t num_directions) {
+	if (num_threads > ctx->num_bemd_workspaces) {
+		ctx->bemd_ws = realloc(ctx->bemd_ws, num_threads*sizeof(bemd_sifting_workspace*));
+		for (size_t i=ctx->num_bemd_workspaces; i<num_threads; i++) {
+			ctx->bemd_ws[i] = NULL;
+		}
+		ctx->num_bemd_workspaces = num_threads;
+	}
+	if (N > ctx->bemd_capacity || ctx->bemd_x == NULL) {
+		free(ctx->bemd_res);
+		free(ctx->bemd_x);
+		ctx->bemd_x = malloc(2*N*sizeof(double));
+		ctx->bemd_res = malloc(2*N*sizeof(double));
+		ctx->bemd_capacity = N;
+	}
+	if (num_directions > ctx->bemd_units_size || ctx->bemd_units == NULL) {
+		free(ctx->bemd_units);
+		ctx->bemd_units = malloc(2*num_directions*sizeof(double));
+		ctx->bemd_units_size = num_directions;
+	}
+}
+
+bemd_sifting_workspace* get_context_bemd_workspace(eemd_context* ctx, size_t thread_id,
+		size_t N) {
+	bemd_sifting_workspace* w = ctx->bemd_ws[thread_id];
+	if (w == NULL || w->capacity < N) {
+		if (w != NULL) {
+			free_bemd_sifting_workspace(w);
+		}
+		w = allocate_bemd_sifting_workspace(N);
+		ctx->bemd_ws[thread_id] = w;
+	}
+	w->N = N;
+	w->lanes->N = N;
+	return w;
+}
@@ -0,0 +1,109 @@
+/*
+ ** Persistent decomposition context for Rlibeemd:
+ ** Owns the workspaces, random number generators, locks and shared buffers
+ ** used by eemd, ceemdan and bemd, so that repeated decompositions do not
+ ** need to allocate them again. The buffers are only reallocated when a
+ ** larger signal, more threads or more memory is needed. A context must not
+ ** be used by several decompositions at the same time.
+ */
+
+#ifndef _EEMD_CONTEXT_H_
+#define _EEMD_CONTEXT_H_
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <R_ext/Complex.h>
+
+#include "lock.h"
+#include "workspace.h"
+#include "bemd.h"
+#include "eemd.h"
+
+struct eemd_context {
+	// Workspaces for each thread, including the random number generators
+	size_t num_workspaces;
+	eemd_workspace** ws;
+	// Locks for shared output matrices
+	size_t num_locks;
+	lock** locks;
+	// Extra output matrices for sharded EEMD
+	size_t shard_outputs_size;
+	double* shard_outputs;
+	// Partial output matrices of the NUMA domains
+	size_t domain_outputs_size;
+	double* domain_outputs;
+	// Private output matrices of the threads, also holding the partial sums
+	// of CEEMDAN, and sums of squares for the adaptive ensemble size
+	size_t member_outputs_size;
+	double* member_outputs;
+	size_t sumsq_size;
+	double* sumsq;
+	// Noises of the members of each thread, the stored residuals of the
+	// noises and the shared residual for CEEMDAN
+	size_t noises_size;
+	double* noises;
+	size_t noise_residuals_size;
+	double* noise_residuals;
+	size_t res_size;
+	double* res;
+	// Workspaces of the threads for BEMD, the signal and its residual, each
+	// stored as the real parts followed by the imaginary parts, and the
+	// cosines followed by the sines of the directions
+	size_t num_bemd_workspaces;
+	bemd_sifting_workspace** bemd_ws;
+	size_t bemd_capacity;
+	double* bemd_x;
+	double* bemd_res;
+	size_t bemd_units_size;
+	double* bemd_units;
+	// Directory of the cache of the noise modes of CEEMDAN, or NULL
+	char* noise_cache_dir;
+};
+
+// Make room for the workspaces of num_threads threads. This needs to be
+// called before entering a parallel region.
+void reserve_context_threads(eemd_context* ctx, size_t num_threads);
+
+// Return the workspace of thread thread_id with length set to N and arrays
+// of the given precision. The workspace is allocated or grown if necessary.
+// Each thread should call this for itself, so that the memory is first
+// touched by the thread using it.
+eemd_workspace* get_context_workspace(eemd_context* ctx, size_t thread_id, size_t N,
+		libeemd_precision precision);
+
+// Return an array of at least num_locks initialized locks
+lock** get_context_locks(eemd_context* ctx, size_t num_locks);
+
+// Return a buffer of at least size doubles for the extra outputs of sharded
+// EEMD
+double* get_context_shard_outputs(eemd_context* ctx, size_t size);
+
+// Return a buffer of at least size doubles for the partial outputs of the
+// NUMA domains. The contents should be first touched by the threads of each
+// domain.
+double* get_context_domain_outputs(eemd_context* ctx, size_t size);
+
+// Return a buffer of at least size doubles for the private output matrices
+// of the threads
+double* get_context_member_outputs(eemd_context* ctx, size_t size);
+
+// Return a buffer of at least size doubles for sums of squares
+double* get_context_sumsq(eemd_context* ctx, size_t size);
+
+// Make room for the noises (noises_size doubles), the stored noise residuals
+// (residuals_size doubles) and the residual (res_size doubles) of CEEMDAN
+void reserve_context_noises(eemd_context* ctx, size_t noises_size, size_t residuals_size,
+		size_t res_size);
+
+// Make room for BEMD of a signal of length N with num_threads threads and
+// num_directions directions. This needs to be called before entering a
+// parallel region.
+void reserve_context_bemd(eemd_context* ctx, size_t N, size_t num_threads,
+		size_t num_directions);
+
+// Return the BEMD workspace of thread thread_id with length set to N. As with
+// get_context_workspace, each thread should call this for itself.
+bemd_sifting_workspace* get_context_bemd_workspace(eemd_context* ctx, size_t thread_id,
+		size_t N);
+
+#endif // _EEMD_CONTEXT_H_
@@ -0,0 +1,33 @@
+#include "contextR.h"
+
+using namespace Rcpp;
+
+static void finalize_eemd_context(eemd_context* ctx) {
+  free_eemd_context(ctx);
+}
+
+typedef XPtr<eemd_context, PreserveStorage, finalize_eemd_context, true> eemd_context_ptr;
+
+eemd_context* context_pointer(SEXP context) {
+  if (Rf_isNull(context)) {
+    return NULL;
+  }
+  eemd_context_ptr ctx(context);
+  return ctx.checked_get();
+}
+
+// [[Rcpp::export]]
+SEXP emd_contextR(SEXP noise_cache = R_NilValue){
+  
+  // The context is owned by the pointer before setting the cache, so that it
+  // is freed if the directory is not valid
+  eemd_context_ptr ctx(allocate_eemd_context(), true);
+  if (!Rf_isNull(noise_cache)) {
+    std::string directory = as<std::string>(noise_cache);
+    libeemd_error_code err = set_eemd_context_noise_cache(ctx.checked_get(), directory.c_str());
+    if (err != EMD_SUCCESS) {
+      printError(err);
+    }
+  }
+  return ctx;
+}
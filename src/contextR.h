@@ -0,0 +1,15 @@
+#ifndef CONTEXTR_H
+#define CONTEXTR_H
+
+#include <Rcpp.h>
+
+extern "C"
+{
+  #include "eemd.h"
+}
+
+// Return the context stored in an external pointer created by emd_contextR,
+// or NULL if context is NULL in R
+eemd_context* context_pointer(SEXP context);
+
+#endif
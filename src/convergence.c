@@ -0,0 +1,34 @@
+/*
+ ** Convergence monitoring of ensemble means for Rlibeemd, see convergence.h
+ */
+
+#include "convergence.h"
+
+bool ensemble_converged(double const* __restrict sum, double const* __restrict sumsq,
+		size_t N, size_t M, size_t n, unsigned int m, double tolerance, double scale) {
+	if (n < 2) {
+		return false;
+	}
+	// The samples are y_j = c_j/m, where c_j is the sum of m members, so that
+	// the mean of y_j is the ensemble mean
+	const double one_per_nm = 1.0/((double)n*m);
+	const double one_per_mm = 1.0/((double)m*m);
+	const double limit = tolerance*scale;
+	for (size_t imf_i=0; imf_i<M; imf_i++) {
+		double const* const s = sum+imf_i*N;
+		double const* const q = sumsq+imf_i*N;
+		// Sum of the squared standard errors of the mean over the signal
+		double se2 = 0;
+		for (size_t i=0; i<N; i++) {
+			const double mean = s[i]*one_per_nm;
+			const double var = (q[i]*one_per_mm - n*mean*mean)/(n-1);
+			if (var > 0) {
+				se2 += var/n;
+			}
+		}
+		if (sqrt(se2/N) > limit) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,24 @@
+/*
+ ** Convergence monitoring of ensemble means for Rlibeemd:
+ ** Used by the adaptive ensemble size of eemd and ceemdan, which stop adding
+ ** ensemble members once the standard error of the ensemble mean is small
+ ** enough.
+ */
+
+#ifndef _EEMD_CONVERGENCE_H_
+#define _EEMD_CONVERGENCE_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <math.h>
+
+// Check the convergence of an ensemble mean of M signals of length N (e.g.
+// IMFs), stored one after another. The arrays sum and sumsq contain the sums
+// and the sums of squares over n independent samples, where each sample is
+// the sum of m ensemble members. Returns true if for each of the M signals
+// the root mean square of the standard error of the ensemble mean is at most
+// tolerance*scale. At least two samples are needed to estimate the error.
+bool ensemble_converged(double const* __restrict sum, double const* __restrict sumsq,
+		size_t N, size_t M, size_t n, unsigned int m, double tolerance, double scale);
+
+#endif // _EEMD_CONVERGENCE_H_
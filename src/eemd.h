@@ -5,6 +5,21 @@
 //   emd_report_if_error
 //   emd_report_to_file_if_error
 // Moved bemd to bemd.h 
+// Added parameter num_shards to eemd
+// Added eemd_batch and ceemdan_batch
+// Added eemd_context and parameter ctx to eemd, ceemdan and the batched versions
+// Added libeemd_rng and parameter rng to eemd, ceemdan and the batched versions
+// Added parameter complementary to eemd and eemd_batch
+// Added parameters tolerance and ensemble_used to eemd, ceemdan and the batched versions
+// Added libeemd_precision and parameter precision to eemd and eemd_batch
+// Added emd_stats and parameter stats to eemd, ceemdan and the batched versions
+// Added libeemd_affinity and parameter affinity to eemd
+// Added emd_stopping and parameter stopping to eemd, ceemdan and the batched versions
+// Added libeemd_interpolation and parameter interpolation to eemd, ceemdan, the batched versions and bemd
+// Added parameter memory_limit to ceemdan and ceemdan_batch
+// Added set_eemd_context_noise_cache
+// Added iceemdan and iceemdan_batch
+// Added parameter threads to bemd
 
 #include "extras.h"
 
@@ -40,6 +55,7 @@
 #endif
 
 #include <stddef.h>
+#include <stdint.h>
 //#include <complex.h>
 #include <stdbool.h>
 // No need for this in Rlibeemd
@@ -53,6 +69,150 @@
 // void emd_report_if_error(libeemd_error_code err);
 // void emd_report_to_file_if_error(FILE* file, libeemd_error_code err);
 
+// A persistent context owning the workspaces, random number generators and
+// other memory needed by the decomposition routines. Passing the same context
+// to repeated calls avoids allocating this memory every time; it is only
+// grown when a longer signal, more threads or a larger ensemble is
+// encountered. A context can be used by only one decomposition at a time. All
+// routines taking a parameter 'ctx' accept NULL, in which case the memory is
+// allocated and freed within the call.
+typedef struct eemd_context eemd_context;
+eemd_context* allocate_eemd_context(void);
+void free_eemd_context(eemd_context* ctx);
+
+// Keep the noises of CEEMDAN and their modes in a cache in directory, so
+// that ceemdan and ceemdan_batch can skip the decomposition of the noises
+// when the context is used again for a signal of the same length, or by
+// another process using the same directory. The cache is a memory-mapped
+// file for each length of the signal and set of parameters of the noise,
+// and it is only used on POSIX systems. The directory must exist. NULL
+// stops using the cache.
+libeemd_error_code set_eemd_context_noise_cache(eemd_context* ctx, char const* directory);
+
+// Optional instrumentation of the decomposition routines. If a routine is
+// given a non-NULL stats, it is filled with the statistics of that call;
+// otherwise no statistics are collected. The arrays are owned by the struct
+// and grown as needed, so the same struct can be reused for several calls.
+typedef struct {
+	// Number of IMFs covered by the per-IMF arrays. For the batched routines
+	// this is the largest number of IMFs among the series.
+	size_t num_imfs;
+	// Number of sifting runs that produced each IMF (ensemble members, or
+	// members times series for the batched routines) and the minimum, mean
+	// and maximum number of siftings they needed
+	size_t* sift_runs;
+	unsigned int* sift_min;
+	double* sift_mean;
+	unsigned int* sift_max;
+	// Mean number of extrema (maxima plus minima) in the last sifting of each
+	// IMF
+	double* extrema_mean;
+	// Time in seconds spent in the first emd_find_extrema of each IMF, in
+	// the spline fits and the fused pass that subtracts the envelope mean
+	// and finds the extrema of the result, and in adding results to shared
+	// outputs, including waiting for the locks. These are summed over all
+	// threads.
+	double extrema_time;
+	double spline_time;
+	double accumulate_time;
+	// Wall clock time of the parallel part of the routine
+	double wall_time;
+	// Time each of the num_threads threads spent working on ensemble members
+	// and the rest of wall_time, spent waiting for other threads
+	size_t num_threads;
+	double* busy_time;
+	double* idle_time;
+} emd_stats;
+emd_stats* allocate_emd_stats(void);
+void free_emd_stats(emd_stats* stats);
+
+// Random number generators for the added noise
+typedef enum {
+	// GSL's Mersenne twister. Ensemble member i is seeded with rng_seed+i.
+	EMD_RNG_MT19937 = 0,
+	// Counter-based Philox4x32-10 (see philox.h). The noise of ensemble member
+	// i is stream i of key rng_seed, so no generator state is needed.
+	EMD_RNG_PHILOX = 1
+} libeemd_rng;
+
+// Floating point precision of the sifting. The extrema, spline coefficients
+// and the accumulated IMFs are always in double precision.
+typedef enum {
+	EMD_DOUBLE = 0,
+	// The ensemble members, residuals and envelopes are stored as floats,
+	// which halves the memory traffic of the sifting
+	EMD_FLOAT = 1
+} libeemd_precision;
+
+// Placement of the threads and the memory they use on NUMA systems. The
+// NUMA domains are the OpenMP places, e.g. OMP_PLACES=sockets, see numa.h.
+typedef enum {
+	EMD_AFFINITY_NONE = 0,
+	// The output matrix is first touched by the threads in blocks, and the
+	// threads of each domain sum their members to a partial output matrix
+	// in memory local to the domain. The partial matrices are merged to the
+	// output at the end.
+	EMD_AFFINITY_NUMA = 1,
+	// As above, and the threads are also pinned to the processors of their
+	// domain during the decomposition
+	EMD_AFFINITY_PIN = 2
+} libeemd_affinity;
+
+// Criterion for ending the sifting of an IMF. The criteria other than the
+// S-number are evaluated from the envelope mean while it is subtracted, and
+// the sifting ends after the first sifting whose envelope mean satisfies the
+// criterion. The maximum number of siftings is still num_siftings if it is
+// nonzero.
+typedef enum {
+	// Number of extrema stable for S_number siftings, see eemd below
+	EMD_STOP_S_NUMBER = 0,
+	// Cauchy-type criterion of Huang et al. (1998): the sum of squares of the
+	// envelope mean divided by the sum of squares of the signal before the
+	// sifting is below sd_limit
+	EMD_STOP_SD = 1,
+	// Criterion of G. Rilling, P. Flandrin and P. Gonçalvès, On Empirical
+	// Mode Decomposition and its Algorithms, IEEE-EURASIP Workshop on
+	// Nonlinear Signal and Image Processing NSIP-03 (2003): the ratio of the
+	// envelope mean and the envelope amplitude (half of the difference of
+	// the envelopes) exceeds theta_1 in at most a fraction alpha of the
+	// signal, and it nowhere exceeds theta_2
+	EMD_STOP_RILLING = 2
+} libeemd_stopping;
+
+// A stopping criterion and its thresholds. Only the thresholds of the chosen
+// criterion are used. The values suggested in the articles are sd_limit=0.2,
+// and theta_1=0.05, theta_2=0.5 and alpha=0.05.
+typedef struct {
+	libeemd_stopping criterion;
+	double sd_limit;
+	double theta_1;
+	double theta_2;
+	double alpha;
+} emd_stopping;
+
+// Interpolation of the envelopes through the extrema in the sifting. The
+// alternatives to the cubic spline only depend on the neighbouring extrema,
+// so they need no linear system, but the envelopes are less smooth.
+typedef enum {
+	// Cubic spline with not-a-knot end conditions, see emd_evaluate_spline
+	EMD_INTERP_SPLINE = 0,
+	// Straight lines between the extrema
+	EMD_INTERP_LINEAR = 1,
+	// Monotone piecewise cubic Hermite interpolation of F. N. Fritsch and
+	// R. E. Carlson, Monotone Piecewise Cubic Interpolation, SIAM J. Numer.
+	// Anal. 17 (1980) 238-246, same as Matlab's pchip
+	EMD_INTERP_PCHIP = 2,
+	// Piecewise cubic of H. Akima, A New Method of Interpolation and Smooth
+	// Curve Fitting Based on Local Procedures, J. ACM 17 (1970) 589-602
+	EMD_INTERP_AKIMA = 3
+} libeemd_interpolation;
+
+// Number of realizations of noise between the convergence checks of an
+// adaptive ensemble size
+#ifndef EEMD_CONVERGENCE_INTERVAL
+#define EEMD_CONVERGENCE_INTERVAL 16
+#endif
+
 // Main EEMD decomposition routine as described in:
 //   Z. Wu and N. Huang,
 //   Ensemble Empirical Mode Decomposition: A Noise-Assisted Data Analysis
@@ -70,16 +230,68 @@
 // respectively. These are followed by the parameters for the stopping
 // criterion. The stopping parameter can be defined by a S-number (see the
 // article for details) or a fixed number of siftings. If both are specified,
-// the sifting ends when either criterion is fulfilled. The final parameter is
+// the sifting ends when either criterion is fulfilled. The next parameter is
 // the seed given to the random number generator. A value of zero denotes a
-// RNG-specific default value.
+// RNG-specific default value. The random number generator itself is chosen
+// with parameter rng. The final parameter is an optional persistent context,
+// see eemd_context above.
+//
+// If num_shards is zero, all threads add their results to the output matrix
+// protected by a lock for each IMF. Otherwise the ensemble is split into
+// num_shards blocks of consecutive members, and each block is summed to its
+// own output matrix without locking. These partial sums are then combined in
+// a fixed order, so that the result is bit-identical regardless of the
+// number of threads. This requires memory for num_shards-1 extra N*M
+// matrices, and at most num_shards threads are used for the decomposition.
+//
+// If complementary is true, the ensemble consists of pairs of members using
+// the same realization of noise with opposite signs, so that the added noise
+// cancels exactly in the ensemble mean (complementary EEMD). Both members of
+// a pair run on the same thread, and the noise is generated only once. The
+// ensemble_size should then be even; for odd sizes the last realization is
+// used only once. The shards above then consist of pairs of members.
+//
+// If tolerance is positive, ensemble_size is only an upper limit for the
+// ensemble size. The realizations of noise are then added in rounds of
+// EEMD_CONVERGENCE_INTERVAL, and after each round the standard error of the
+// ensemble mean is estimated from the spread of the members. The ensemble is
+// considered converged when the root mean square of this standard error is
+// at most tolerance times the standard deviation of the input data for every
+// IMF. The rounds do not depend on the number of threads, so the result is
+// reproducible. This requires N*M doubles of extra memory per thread and
+// disables sharding. If ensemble_used is not NULL, the number of members
+// actually used is written there.
+//
+// With precision EMD_FLOAT each ensemble member (input data + noise) is
+// rounded to float and decomposed in single precision. The IMFs are
+// accumulated to the output in double precision.
+//
+// If stats is not NULL, it is filled with timing and sifting statistics of
+// the call, see emd_stats above.
+//
+// With affinity EMD_AFFINITY_NUMA or EMD_AFFINITY_PIN the threads are
+// assigned to NUMA domains, see libeemd_affinity above. Unless sharding or an
+// adaptive ensemble size is used, this requires memory for one extra N*M
+// matrix per domain. The workspaces in the context are always allocated by
+// the threads using them.
+//
+// If stopping is not NULL, the sifting ends according to the criterion it
+// gives, see libeemd_stopping above. S_number is then only used with
+// EMD_STOP_S_NUMBER, and num_siftings may be zero with the other criteria.
+//
+// The envelopes are interpolated as given by interpolation, see
+// libeemd_interpolation above.
 //
 // To compute the original EMD decomposition you can use this function with
 // ensemble_size = 1 and noise_strength = 0.
 libeemd_error_code eemd(double const* __restrict input, size_t N,
 		double* __restrict output, size_t M,
 		unsigned int ensemble_size, double noise_strength, unsigned int
-		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads);
+		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads,
+		unsigned int num_shards, libeemd_rng rng, bool complementary,
+		double tolerance, unsigned int* ensemble_used, libeemd_precision precision,
+		libeemd_affinity affinity, emd_stopping const* stopping,
+		libeemd_interpolation interpolation, emd_stats* stats, eemd_context* ctx);
 
 // A complete variant of EEMD as described in:
 //   M. Torres et al,
@@ -87,11 +299,86 @@ libeemd_error_code eemd(double const* __restrict input, size_t N,
 //   IEEE Int. Conf. on Acoust., Speech and Signal Proc. ICASSP-11,
 //   (2011) 4144-4147
 //
-// Parameters are identical to routine eemd
+// Parameters are identical to routine eemd. With a positive tolerance the
+// convergence is checked separately for each mode, using only the members
+// that were used for the previous mode, so the ensemble can only shrink from
+// one mode to the next. The number of members used for the first mode is
+// written to ensemble_used.
+//
+// Each mode of CEEMDAN uses the same mode of the noise of each member, so
+// the residuals of the noises are kept between the modes. At most
+// memory_limit bytes are used for them, and the noises of the members that
+// do not fit are generated again and decomposed up to the current mode,
+// which gives the same result with more siftings. With memory_limit =
+// SIZE_MAX all residuals are kept, and the memory needed is
+// ensemble_size*N doubles, and with memory_limit = 0 only a few arrays of N
+// doubles per thread are needed.
 libeemd_error_code ceemdan(double const* __restrict input, size_t N,
 		double* __restrict output, size_t M,
 		unsigned int ensemble_size, double noise_strength, unsigned int
-		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads);
+		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads,
+		libeemd_rng rng, double tolerance, unsigned int* ensemble_used,
+		emd_stopping const* stopping, libeemd_interpolation interpolation,
+		size_t memory_limit, emd_stats* stats, eemd_context* ctx);
+
+// Batched versions of eemd and ceemdan for decomposing num_series signals
+// with the same parameters. The input data of series i is given by inputs[i]
+// and N[i], and its IMFs are written to outputs[i], which needs room for
+// N[i]*M doubles. If M is zero, a value of emd_num_imfs(N[i]) is used for
+// each series. The result for each series is the same as calling eemd or
+// ceemdan separately, but the thread team and the workspaces are created only
+// once, and sized for the longest series. In eemd_batch the work is divided
+// among the threads as (series, realization of noise) pairs. In ceemdan_batch the
+// modes of each series depend on each other, so the series are processed one
+// after another with the ensemble members divided among the threads. The
+// ensemble sizes used are written to ensemble_used[i] if it is not NULL, and
+// the statistics in stats cover all series.
+libeemd_error_code eemd_batch(double const* const* inputs, size_t const* N,
+		size_t num_series, double* const* outputs, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads,
+		libeemd_rng rng, bool complementary, double tolerance,
+		unsigned int* ensemble_used, libeemd_precision precision,
+		emd_stopping const* stopping, libeemd_interpolation interpolation,
+		emd_stats* stats, eemd_context* ctx);
+libeemd_error_code ceemdan_batch(double const* const* inputs, size_t const* N,
+		size_t num_series, double* const* outputs, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads,
+		libeemd_rng rng, double tolerance, unsigned int* ensemble_used,
+		emd_stopping const* stopping, libeemd_interpolation interpolation,
+		size_t memory_limit, emd_stats* stats, eemd_context* ctx);
+
+// The improved CEEMDAN as described in:
+//   M. A. Colominas, G. Schlotthauer and M. E. Torres,
+//   Improved complete ensemble EMD: A suitable tool for biomedical signal
+//   processing, Biomedical Signal Processing and Control 14 (2014) 19-29
+//
+// Instead of averaging the first IMFs of the residual plus noise, each mode
+// averages the local means of the members, i.e. what remains of the residual
+// plus noise after its first IMF is sifted out, and the mode is the
+// difference of the residual and this mean. Mode k of the output uses mode
+// k+1 of the noise, so the white noise itself is never added, and the
+// noise is scaled by noise_strength times the standard deviation of the
+// residual, normalized only for the first mode. The last row of the output
+// is the final residual. This reduces the residual noise in the modes and
+// the spurious modes of CEEMDAN. The parameters, the memory used for the
+// noises, the batched version and the cache of the noise modes are the same
+// as for ceemdan.
+libeemd_error_code iceemdan(double const* __restrict input, size_t N,
+		double* __restrict output, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads,
+		libeemd_rng rng, double tolerance, unsigned int* ensemble_used,
+		emd_stopping const* stopping, libeemd_interpolation interpolation,
+		size_t memory_limit, emd_stats* stats, eemd_context* ctx);
+libeemd_error_code iceemdan_batch(double const* const* inputs, size_t const* N,
+		size_t num_series, double* const* outputs, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads,
+		libeemd_rng rng, double tolerance, unsigned int* ensemble_used,
+		emd_stopping const* stopping, libeemd_interpolation interpolation,
+		size_t memory_limit, emd_stats* stats, eemd_context* ctx);
 
 // A method for finding the local minima and maxima from input data specified
 // with parameters x and N. The memory for storing the coordinates of the
@@ -112,9 +399,12 @@ size_t emd_num_imfs(size_t N);
 // evaluated at integer points from 0 to x[N-1], and these y values will be
 // written to the array spline_y. The endpoint x[N-1] is assumed to be an
 // integer, and the x values are assumed to be in ascending order, with x[0]
-// equal to 0. The workspace required is 5*N-10 doubles, except that N==2
-// requires no extra memory. For N<=3 the routine falls back to polynomial
-// interpolation, same as Matlab.
+// equal to 0. The workspace required is 3*N-4 doubles, or N doubles for
+// N<=3, where the routine falls back to polynomial interpolation, same as
+// Matlab. The spline system is eliminated from scratch on every call. The
+// sifting routines instead keep the elimination in a spline_system (see
+// spline.h) and only eliminate the rows near moved knots again, so callers
+// passing only a workspace get no such reuse.
 //
 // This routine is mainly exported so that it can be tested separately to
 // produce identical results to the Matlab routine 'spline'.
@@ -4,13 +4,19 @@ extern "C"
 {
   #include "eemd.h"
 }
+#include "contextR.h"
+#include "statsR.h"
+#include "stoppingR.h"
 
 using namespace Rcpp;
 
 // [[Rcpp::export]]
 NumericMatrix eemdR(NumericVector input, double num_imfs=0, unsigned int ensemble_size=250, 
 double noise_strength=0.2, unsigned int S_number=4, unsigned int num_siftings=50, 
-unsigned long int rng_seed=0, int threads=0){
+unsigned long int rng_seed=0, int threads=0, unsigned int num_shards=0, int rng=0, 
+bool complementary=false, double tolerance=0, int precision=0, int affinity=0, 
+int stopping=0, SEXP stopping_thresholds=R_NilValue, int interpolation=0, bool stats=false, 
+SEXP context=R_NilValue){
   
   
   size_t N = input.size();
@@ -21,12 +27,64 @@ unsigned long int rng_seed=0, int threads=0){
     M = (size_t)num_imfs;
   }
   NumericMatrix output(static_cast<int>(N), static_cast<int>(M));
+  unsigned int ensemble_used = ensemble_size;
+  emd_stats* emd_stats_ptr = stats ? allocate_emd_stats() : NULL;
+  emd_stopping criterion;
   libeemd_error_code err = eemd(input.begin(), N, output.begin(), M, 
-    ensemble_size, noise_strength, S_number, num_siftings, rng_seed, threads);
+    ensemble_size, noise_strength, S_number, num_siftings, rng_seed, threads, num_shards,
+    (libeemd_rng)rng, complementary, tolerance, &ensemble_used, (libeemd_precision)precision, 
+    (libeemd_affinity)affinity, stopping_criterion(stopping, stopping_thresholds, &criterion),
+    (libeemd_interpolation)interpolation, emd_stats_ptr, context_pointer(context));
   
  
+  RObject stats_output = stats_list(emd_stats_ptr);
   if(err!=EMD_SUCCESS){
     printError(err);
   }
+  output.attr("ensemble_size") = static_cast<int>(ensemble_used);
+  output.attr("stats") = stats_output;
   return output;
 }
+
+// [[Rcpp::export]]
+List eemd_batchR(List inputs, double num_imfs=0, unsigned int ensemble_size=250, 
+double noise_strength=0.2, unsigned int S_number=4, unsigned int num_siftings=50, 
+unsigned long int rng_seed=0, int threads=0, int rng=0, bool complementary=false, 
+double tolerance=0, int precision=0, int stopping=0, SEXP stopping_thresholds=R_NilValue, 
+int interpolation=0, bool stats=false, SEXP context=R_NilValue){
+  
+  size_t num_series = inputs.size();
+  std::vector<NumericVector> x(num_series);
+  std::vector<size_t> N(num_series);
+  std::vector<double const*> input_ptrs(num_series);
+  std::vector<double*> output_ptrs(num_series);
+  std::vector<unsigned int> ensemble_used(num_series, ensemble_size);
+  List outputs(num_series);
+  emd_stats* emd_stats_ptr = stats ? allocate_emd_stats() : NULL;
+  emd_stopping criterion;
+  for (size_t i = 0; i < num_series; i++) {
+    x[i] = as<NumericVector>(inputs[i]);
+    N[i] = x[i].size();
+    size_t M = (num_imfs==0) ? emd_num_imfs(N[i]) : (size_t)num_imfs;
+    NumericMatrix output(static_cast<int>(N[i]), static_cast<int>(M));
+    input_ptrs[i] = x[i].begin();
+    output_ptrs[i] = output.begin();
+    outputs[i] = output;
+  }
+  libeemd_error_code err = eemd_batch(input_ptrs.data(), N.data(), num_series,
+    output_ptrs.data(), (size_t)num_imfs, ensemble_size, noise_strength, 
+    S_number, num_siftings, rng_seed, threads, (libeemd_rng)rng, complementary, 
+    tolerance, ensemble_used.data(), (libeemd_precision)precision, 
+    stopping_criterion(stopping, stopping_thresholds, &criterion), 
+    (libeemd_interpolation)interpolation, emd_stats_ptr, context_pointer(context));
+  
+  RObject stats_output = stats_list(emd_stats_ptr);
+  if(err!=EMD_SUCCESS){
+    printError(err);
+  }
+  for (size_t i = 0; i < num_series; i++) {
+    as<NumericMatrix>(outputs[i]).attr("ensemble_size") = static_cast<int>(ensemble_used[i]);
+  }
+  outputs.attr("stats") = stats_output;
+  return outputs;
+}
@@ -18,17 +18,165 @@
 
 #include "eemd_routine.h"
 
+// Number of ensemble members using realization of noise noise_i. In
+// complementary EEMD each realization is used by two members, except for the
+// last one if the ensemble size is odd.
+static inline unsigned int _eemd_members_per_noise(size_t noise_i,
+		unsigned int ensemble_size, bool complementary) {
+	return (complementary && 2*noise_i+1 < ensemble_size)? 2 : 1;
+}
+
+// Add the IMFs of a realization of noise from a private buffer to the output
+// and their squares to sumsq, both protected by a lock for each IMF. The
+// time taken is added to stats unless it is NULL.
+static void _eemd_accumulate(double const* __restrict member_output, size_t N, size_t M,
+		double* __restrict output, double* __restrict sumsq, lock** locks,
+		emd_thread_stats* stats) {
+	const double t = (stats != NULL)? emd_wtime() : 0;
+	for (size_t imf_i=0; imf_i<M; imf_i++) {
+		get_lock(locks[imf_i]);
+		array_add(member_output+imf_i*N, N, output+imf_i*N);
+		array_add_squares(member_output+imf_i*N, N, sumsq+imf_i*N);
+		release_lock(locks[imf_i]);
+	}
+	if (stats != NULL) {
+		stats->accumulate_time += emd_wtime() - t;
+	}
+}
+
+// Number of ensemble members using the first num_noises realizations of noise
+static inline unsigned int _eemd_members_of_noises(size_t num_noises,
+		unsigned int ensemble_size, bool complementary) {
+	if (!complementary) {
+		return (unsigned int)num_noises;
+	}
+	return (2*num_noises < ensemble_size)? (unsigned int)(2*num_noises) : ensemble_size;
+}
+
+// Decompose the ensemble member x = input + sign*noise with EMD in the
+// precision of workspace w and add the IMFs to output. The noise is omitted
+// if it is NULL.
+static libeemd_error_code _eemd_decompose_member(double const* __restrict input,
+		double const* __restrict noise, double sign, size_t N,
+		double* __restrict output, size_t M, unsigned int S_number,
+		unsigned int num_siftings, eemd_workspace* w) {
+	if (w->precision == EMD_FLOAT) {
+		float* const x = w->x_f;
+		if (noise == NULL) {
+			for (size_t i=0; i<N; i++) {
+				x[i] = (float)input[i];
+			}
+		}
+		else {
+			for (size_t i=0; i<N; i++) {
+				x[i] = (float)(input[i] + sign*noise[i]);
+			}
+		}
+		return _emd_f(x, w->emd_w_f, output, M, S_number, num_siftings);
+	}
+	double* const x = w->x;
+	if (noise == NULL) {
+		array_copy(input, N, x);
+	}
+	else {
+		for (size_t i=0; i<N; i++) {
+			x[i] = input[i] + sign*noise[i];
+		}
+	}
+	return _emd(x, w->emd_w, output, M, S_number, num_siftings);
+}
+
+// Helper function for computing the ensemble members of EEMD sharing the
+// realization of noise noise_i: the input data plus the noise is decomposed
+// with EMD, and the IMFs are added to output. If num_members is two, the
+// input data minus the same noise is decomposed as well, so that the noise
+// cancels in the ensemble mean. The noise is determined by rng_seed and
+// noise_i only.
+static libeemd_error_code _eemd_noisy_members(double const* __restrict input, size_t N,
+		double* __restrict output, size_t M, double noise_sigma,
+		unsigned int S_number, unsigned int num_siftings, unsigned long int rng_seed,
+		size_t noise_i, unsigned int num_members, libeemd_rng rng, eemd_workspace* w) {
+	double* const noise = w->noise;
+	if (rng == EMD_RNG_PHILOX) {
+		// The counter-based generator computes the noise directly from the
+		// seed and the index of the realization
+		philox_gaussian(rng_seed, noise_i, 0, N, noise_sigma, noise);
+	}
+	else {
+		// set rng seed based on the realization to ensure
+		// reproducibility even in a multithreaded case
+		set_rng_seed(w, rng_seed+noise_i);
+		for (size_t i=0; i<N; i++) {
+			noise[i] = gsl_ran_gaussian(w->r, noise_sigma);
+		}
+	}
+	// Initialize ensemble member as input data + noise and extract IMFs with
+	// EMD
+	libeemd_error_code err = _eemd_decompose_member(input, noise, 1.0, N,
+			output, M, S_number, num_siftings, w);
+	if (err != EMD_SUCCESS || num_members == 1) {
+		return err;
+	}
+	// The complementary member is input data - noise
+	return _eemd_decompose_member(input, noise, -1.0, N, output, M, S_number, num_siftings, w);
+}
+
+// Compute the ensemble members of realization noise_i with
+// _eemd_noisy_members, or plain EMD if there is no noise. The time taken is
+// the busy time of the thread in the statistics.
+static libeemd_error_code _eemd_ensemble_members(double const* __restrict input, size_t N,
+		double* __restrict output, size_t M, double noise_sigma,
+		unsigned int S_number, unsigned int num_siftings, unsigned long int rng_seed,
+		size_t noise_i, unsigned int num_members, libeemd_rng rng, eemd_workspace* w) {
+	emd_thread_stats* const stats = w->stats;
+	const double t = (stats != NULL)? emd_wtime() : 0;
+	libeemd_error_code err = EMD_SUCCESS;
+	if (noise_sigma == 0.0) {
+		err = _eemd_decompose_member(input, NULL, 0, N, output, M, S_number, num_siftings, w);
+	}
+	else {
+		err = _eemd_noisy_members(input, N, output, M, noise_sigma, S_number,
+				num_siftings, rng_seed, noise_i, num_members, rng, w);
+	}
+	if (stats != NULL) {
+		stats->busy_time += emd_wtime() - t;
+	}
+	return err;
+}
+
 // Main EEMD decomposition routine definition
 libeemd_error_code eemd(double const* __restrict input, size_t N,
 		double* __restrict output, size_t M,
 		unsigned int ensemble_size, double noise_strength, unsigned int
-		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads) {
+		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads,
+		unsigned int num_shards, libeemd_rng rng, bool complementary,
+		double tolerance, unsigned int* ensemble_used, libeemd_precision precision,
+		libeemd_affinity affinity, emd_stopping const* stopping,
+		libeemd_interpolation interpolation, emd_stats* stats, eemd_context* ctx) {
 	gsl_set_error_handler_off();
 	// Validate parameters
-	libeemd_error_code validation_result = validate_eemd_parameters(ensemble_size, noise_strength, S_number, num_siftings);
+	libeemd_error_code validation_result = validate_eemd_parameters(ensemble_size, noise_strength, S_number, num_siftings, stopping);
+	if (validation_result == EMD_SUCCESS) {
+		validation_result = validate_rng(rng);
+	}
+	if (validation_result == EMD_SUCCESS) {
+		validation_result = validate_precision(precision);
+	}
+	if (validation_result == EMD_SUCCESS) {
+		validation_result = validate_stopping(stopping);
+	}
+	if (validation_result == EMD_SUCCESS) {
+		validation_result = validate_interpolation(interpolation);
+	}
+	if (validation_result == EMD_SUCCESS) {
+		validation_result = validate_affinity(affinity);
+	}
 	if (validation_result != EMD_SUCCESS) {
 		return validation_result;
 	}
+	if (ensemble_used != NULL) {
+		*ensemble_used = ensemble_size;
+	}
 	// For empty data we have nothing to do
 	if (N == 0) {
 		return EMD_SUCCESS;
@@ -38,14 +186,26 @@ libeemd_error_code eemd(double const* __restrict input, size_t N,
 	}
 	// The noise standard deviation is noise_strength times the standard deviation of input data
 	const double noise_sigma = (noise_strength != 0)? gsl_stats_sd(input, 1, N)*noise_strength : 0;
-	
-
-	// Initialize output data to zero
-	memset(output, 0x00, M*N*sizeof(double));
-	// Each thread gets a separate workspace if we are using OpenMP
-	eemd_workspace** ws = NULL;
-	// The locks are shared among all threads
-	lock** locks;
+	// In complementary EEMD the members are processed in pairs sharing the
+	// same realization of noise
+	const size_t num_noises = complementary? (ensemble_size+1)/2 : ensemble_size;
+	// There is no point in having more shards than realizations of noise.
+	// With an adaptive ensemble size the members are summed with locks
+	// instead.
+	const bool adaptive = (tolerance > 0 && num_noises > 1);
+	if (num_shards > num_noises || adaptive) {
+		num_shards = adaptive? 0 : (unsigned int)num_noises;
+	}
+	// Initialize output data to zero. With NUMA placement this is done by
+	// the threads instead, so that the pages are spread over the domains.
+	if (affinity == EMD_AFFINITY_NONE) {
+		memset(output, 0x00, M*N*sizeof(double));
+	}
+	// Use a temporary context if none was given
+	eemd_context* const own_ctx = (ctx == NULL)? allocate_eemd_context() : NULL;
+	if (ctx == NULL) {
+		ctx = own_ctx;
+	}
 	// Don't start unnecessary threads if the ensemble is small
 	#ifdef _OPENMP
 	int old_maxthreads = 1;
@@ -53,93 +213,538 @@ libeemd_error_code eemd(double const* __restrict input, size_t N,
 	  old_maxthreads = omp_get_max_threads();
 	  omp_set_num_threads(threads);    
 	}
-	if (omp_get_num_threads() > (int)ensemble_size) {
-	  omp_set_num_threads((int)ensemble_size);
+	if (omp_get_num_threads() > (int)num_noises) {
+	  omp_set_num_threads((int)num_noises);
 	}
+	// Each thread gets a separate workspace if we are using OpenMP
+	const size_t max_threads = (size_t)omp_get_max_threads();
+	#else
+	const size_t max_threads = 1;
+	(void)threads;
 	#endif
+	reserve_context_threads(ctx, max_threads);
+	// With NUMA placement and locking, the threads of each domain sum their
+	// members to a partial output matrix of the domain, protected by its own
+	// locks
+	const size_t num_domains = (affinity != EMD_AFFINITY_NONE)? numa_num_domains() : 1;
+	const bool domain_local = (num_domains > 1 && num_shards == 0 && !adaptive);
+	double* const domain_outputs = domain_local?
+		get_context_domain_outputs(ctx, num_domains*M*N) : NULL;
+	size_t* const domain_threads = domain_local? calloc(num_domains, sizeof(size_t)) : NULL;
+	// The locks are shared among all threads
+	lock** const locks = (num_shards == 0)? get_context_locks(ctx, num_domains*M) : NULL;
+	// With an adaptive ensemble size each thread decomposes its members to a
+	// private output matrix, and the sums of squares of the realizations are
+	// collected for estimating the standard error of the ensemble mean
+	double* const member_outputs = adaptive? get_context_member_outputs(ctx, max_threads*M*N) : NULL;
+	double* const sumsq = adaptive? get_context_sumsq(ctx, M*N) : NULL;
+	if (adaptive) {
+		memset(sumsq, 0x00, M*N*sizeof(double));
+	}
+	const double input_sd = adaptive? gsl_stats_sd(input, 1, N) : 0;
+	size_t num_noises_used = num_noises;
+	bool stop_adaptive = false;
+	// In sharded mode each shard has its own output matrix. The first shard
+	// uses the actual output matrix, so only num_shards-1 extra matrices are
+	// needed.
+	double* const shard_outputs = (num_shards > 1)?
+		get_context_shard_outputs(ctx, (num_shards-1)*M*N) : NULL;
 	unsigned int ensemble_counter = 0;
+	// Each thread collects its own statistics if they were requested
+	emd_thread_stats* const thread_stats = (stats != NULL)? allocate_thread_stats(max_threads, M) : NULL;
+	size_t team_size = 1;
+	const double start_time = emd_wtime();
 	// The following section is executed in parallel
 	libeemd_error_code emd_err = EMD_SUCCESS;
 	#pragma omp parallel
 	{
 		#ifdef _OPENMP
-	  const size_t num_threads = (size_t)omp_get_num_threads();
 	  const size_t thread_id = (size_t)omp_get_thread_num();
+		#pragma omp master
+		team_size = (size_t)omp_get_num_threads();
 		#if EEMD_DEBUG >= 1
 		#pragma omp single
-		REprintf("Using %d thread(s) with OpenMP.\n", num_threads);
+		REprintf("Using %d thread(s) with OpenMP.\n", omp_get_num_threads());
 		#endif
+		const size_t num_threads = (size_t)omp_get_num_threads();
 		#else
-		const size_t num_threads = 1;
 		const size_t thread_id = 0;
+		const size_t num_threads = 1;
 		#endif
-		#pragma omp single
-		{
-			ws = malloc(num_threads*sizeof(eemd_workspace*));
-			locks = malloc(M*sizeof(lock*));
-			for (size_t i=0; i<M; i++) {
-				locks[i] = malloc(sizeof(lock));
-				init_lock(locks[i]);
+		// The thread is pinned before it touches any memory
+		const size_t domain = numa_thread_domain(thread_id, num_threads, num_domains);
+		numa_binding* const binding = (affinity == EMD_AFFINITY_PIN)? pin_thread(domain) : NULL;
+		// The output is zeroed in the same blocks as the partial outputs are
+		// merged below
+		const size_t total_size = M*N;
+		const size_t block_size = 4096;
+		const size_t num_blocks = (total_size+block_size-1)/block_size;
+		if (affinity != EMD_AFFINITY_NONE) {
+			#pragma omp for schedule(static)
+			for (size_t block_i=0; block_i<num_blocks; block_i++) {
+				const size_t offset = block_i*block_size;
+				const size_t n = (offset+block_size < total_size)? block_size : total_size-offset;
+				memset(output+offset, 0x00, n*sizeof(double));
+			}
+		}
+		// Each thread gets its own workspace from the context
+		eemd_workspace* w = get_context_workspace(ctx, thread_id, N, precision);
+		set_eemd_workspace_stats(w, (thread_stats != NULL)? &thread_stats[thread_id] : NULL);
+		set_eemd_workspace_stopping(w, stopping);
+		set_eemd_workspace_interpolation(w, interpolation);
+		// All threads share the same array of locks. In sharded mode this is
+		// NULL, and _emd writes to the shard output without locking.
+		set_eemd_workspace_locks(w, locks);
+		// The partial output of the domain is zeroed by the threads of the
+		// domain, each taking a slice according to its rank in the domain
+		double* const domain_output = domain_local? domain_outputs+domain*M*N : output;
+		if (domain_local) {
+			size_t domain_rank;
+			#pragma omp critical
+			domain_rank = domain_threads[domain]++;
+			#pragma omp barrier
+			const size_t begin = domain_rank*total_size/domain_threads[domain];
+			const size_t end = (domain_rank+1)*total_size/domain_threads[domain];
+			memset(domain_output+begin, 0x00, (end-begin)*sizeof(double));
+			#pragma omp barrier
+			set_eemd_workspace_locks(w, locks+domain*M);
+		}
+		if (adaptive) {
+			// The members are decomposed to a private matrix without locking
+			set_eemd_workspace_locks(w, NULL);
+			double* const member_output = member_outputs+thread_id*M*N;
+			// The realizations of noise are processed in rounds, and the
+			// convergence is checked after each round. The rounds do not
+			// depend on the number of threads, so neither does the number of
+			// members used.
+			for (size_t noise_begin=0; noise_begin<num_noises; noise_begin+=EEMD_CONVERGENCE_INTERVAL) {
+				const size_t noise_end = (noise_begin+EEMD_CONVERGENCE_INTERVAL < num_noises)?
+					noise_begin+EEMD_CONVERGENCE_INTERVAL : num_noises;
+				#pragma omp for schedule(dynamic)
+				for (size_t noise_i=noise_begin; noise_i<noise_end; noise_i++) {
+					// Check if an error has occured in other threads
+					#pragma omp flush(emd_err)
+					if (emd_err != EMD_SUCCESS) {
+						continue;
+					}
+					const unsigned int num_members = _eemd_members_per_noise(noise_i, ensemble_size, complementary);
+					memset(member_output, 0x00, M*N*sizeof(double));
+					libeemd_error_code err = _eemd_ensemble_members(input, N, member_output, M,
+							noise_sigma, S_number, num_siftings, rng_seed, noise_i, num_members, rng, w);
+					if (err != EMD_SUCCESS) {
+						emd_err = err;
+					}
+					else {
+						_eemd_accumulate(member_output, N, M, output, sumsq, locks, w->stats);
+					}
+					#pragma omp flush(emd_err)
+					#pragma omp atomic
+					ensemble_counter += num_members;
+					#if EEMD_DEBUG >= 1
+					REprintf("Ensemble iteration %u/%u done.\n", ensemble_counter, ensemble_size);
+					#endif
+				}
+				// After the implicit barrier of the loop all threads see the
+				// same sums. The last round may contain a realization used by
+				// only one member, so the convergence is not checked there.
+				// The decision is made by one thread, since emd_err may
+				// change as soon as the first threads start the next round.
+				#pragma omp single
+				{
+					num_noises_used = noise_end;
+					stop_adaptive = (emd_err != EMD_SUCCESS) || (noise_end < num_noises &&
+							ensemble_converged(output, sumsq, N, M, noise_end,
+								complementary? 2 : 1, tolerance, input_sd));
+				}
+				if (stop_adaptive) {
+					break;
+				}
 			}
 		}
-		// Each thread allocates its own workspace
-		ws[thread_id] = allocate_eemd_workspace(N);
-		eemd_workspace* w = ws[thread_id];
-		// All threads share the same array of locks
-		w->emd_w->locks = locks;
-		// Loop over all ensemble members, dividing them among the threads
-		#pragma omp for
-		for (size_t en_i=0; en_i<ensemble_size; en_i++) {
-			// Check if an error has occured in other threads
-			#pragma omp flush(emd_err)
-			if (emd_err != EMD_SUCCESS) {
-				continue;
+		else if (num_shards == 0) {
+			// Loop over all realizations of noise, dividing them among the
+			// threads. The members sharing a realization run on the same thread.
+			#pragma omp for
+			for (size_t noise_i=0; noise_i<num_noises; noise_i++) {
+				// Check if an error has occured in other threads
+				#pragma omp flush(emd_err)
+				if (emd_err != EMD_SUCCESS) {
+					continue;
+				}
+				const unsigned int num_members = _eemd_members_per_noise(noise_i, ensemble_size, complementary);
+				libeemd_error_code err = _eemd_ensemble_members(input, N, domain_output, M,
+						noise_sigma, S_number, num_siftings, rng_seed, noise_i, num_members, rng, w);
+				if (err != EMD_SUCCESS) {
+					emd_err = err;
+				}
+				#pragma omp flush(emd_err)
+				#pragma omp atomic
+				ensemble_counter += num_members;
+				#if EEMD_DEBUG >= 1
+				REprintf("Ensemble iteration %u/%u done.\n", ensemble_counter, ensemble_size);
+				#endif
 			}
-			// Initialize ensemble member as input data + noise
-			if (noise_strength == 0.0) {
-				array_copy(input, N, w->x);
+		}
+		else {
+			// Loop over shards, dividing them among the threads. Each shard is
+			// a fixed block of consecutive realizations of noise, whose
+			// members are always summed in the same order regardless of which
+			// thread runs them.
+			#pragma omp for schedule(dynamic)
+			for (size_t shard_i=0; shard_i<num_shards; shard_i++) {
+				double* const shard_output = (shard_i == 0)? output : shard_outputs+(shard_i-1)*M*N;
+				if (shard_i != 0) {
+					memset(shard_output, 0x00, M*N*sizeof(double));
+				}
+				const size_t noise_begin = shard_i*num_noises/num_shards;
+				const size_t noise_end = (shard_i+1)*num_noises/num_shards;
+				for (size_t noise_i=noise_begin; noise_i<noise_end; noise_i++) {
+					#pragma omp flush(emd_err)
+					if (emd_err != EMD_SUCCESS) {
+						break;
+					}
+					const unsigned int num_members = _eemd_members_per_noise(noise_i, ensemble_size, complementary);
+					libeemd_error_code err = _eemd_ensemble_members(input, N, shard_output, M,
+							noise_sigma, S_number, num_siftings, rng_seed, noise_i, num_members, rng, w);
+					if (err != EMD_SUCCESS) {
+						emd_err = err;
+					}
+					#pragma omp flush(emd_err)
+					#pragma omp atomic
+					ensemble_counter += num_members;
+					#if EEMD_DEBUG >= 1
+					REprintf("Ensemble iteration %u/%u done.\n", ensemble_counter, ensemble_size);
+					#endif
+				}
 			}
-			else {
-				// set rng seed based on ensemble member to ensure
-				// reproducibility even in a multithreaded case
-				set_rng_seed(w, rng_seed+en_i);
-				for (size_t i=0; i<N; i++) {
-					w->x[i] = input[i] + gsl_ran_gaussian(w->r, noise_sigma);
+			// Merge the shards to the output with a pairwise tree reduction.
+			// The order of the additions depends only on num_shards, so the
+			// result is bit-identical for any number of threads. The work is
+			// divided among the threads by splitting the output matrix into
+			// blocks.
+			if (num_shards > 1 && emd_err == EMD_SUCCESS) {
+				const double t = (w->stats != NULL)? emd_wtime() : 0;
+				#pragma omp for schedule(static)
+				for (size_t block_i=0; block_i<num_blocks; block_i++) {
+					const size_t offset = block_i*block_size;
+					const size_t n = (offset+block_size < total_size)? block_size : total_size-offset;
+					for (size_t stride=1; stride<num_shards; stride*=2) {
+						for (size_t shard_i=0; shard_i+stride<num_shards; shard_i+=2*stride) {
+							double* const dest = (shard_i == 0)? output : shard_outputs+(shard_i-1)*M*N;
+							double const* const src = shard_outputs+(shard_i+stride-1)*M*N;
+							array_add(src+offset, n, dest+offset);
+						}
+					}
+				}
+				if (w->stats != NULL) {
+					const double merge_time = emd_wtime() - t;
+					w->stats->accumulate_time += merge_time;
+					w->stats->busy_time += merge_time;
 				}
 			}
-			// Extract IMFs with EMD
-			emd_err = _emd(w->x, w->emd_w, output, M, S_number, num_siftings);
-			#pragma omp flush(emd_err)
-			#pragma omp atomic
-			ensemble_counter++;
-			#if EEMD_DEBUG >= 1
-			REprintf("Ensemble iteration %u/%u done.\n", ensemble_counter, ensemble_size);
-			#endif
-		}
-		// Free resources
-		free_eemd_workspace(w);
-		#pragma omp single
-		{
-			free(ws); ws = NULL;
-			for (size_t i=0; i<M; i++) {
-				destroy_lock(locks[i]);
-				free(locks[i]);
+		}
+		// Merge the partial outputs of the domains. Each thread adds to the
+		// blocks of the output it zeroed itself.
+		if (domain_local) {
+			const double t = (w->stats != NULL)? emd_wtime() : 0;
+			#pragma omp for schedule(static)
+			for (size_t block_i=0; block_i<num_blocks; block_i++) {
+				const size_t offset = block_i*block_size;
+				const size_t n = (offset+block_size < total_size)? block_size : total_size-offset;
+				for (size_t domain_i=0; domain_i<num_domains; domain_i++) {
+					// Domains without threads were never zeroed
+					if (domain_threads[domain_i] > 0) {
+						array_add(domain_outputs+domain_i*M*N+offset, n, output+offset);
+					}
+				}
+			}
+			if (w->stats != NULL) {
+				const double merge_time = emd_wtime() - t;
+				w->stats->accumulate_time += merge_time;
+				w->stats->busy_time += merge_time;
 			}
-			free(locks); locks = NULL;
 		}
+		unpin_thread(binding);
 	} // End of parallel block
+  #ifdef _OPENMP
+	if (threads>0) {
+	  omp_set_num_threads(old_maxthreads);    
+	}
+  #endif
+	if (stats != NULL) {
+		collect_emd_stats(stats, thread_stats, team_size, emd_wtime()-start_time);
+		free_thread_stats(thread_stats, max_threads);
+	}
+	// Free resources
+	free(domain_threads);
+	if (own_ctx != NULL) {
+		free_eemd_context(own_ctx);
+	}
 	if (emd_err != EMD_SUCCESS) {
 		return emd_err;
 	}
-	// Divide output data by the ensemble size to get the average
-	if (ensemble_size != 1) {
-		const double one_per_ensemble_size = 1.0/ensemble_size;
+	// Divide output data by the number of members used to get the average
+	const unsigned int num_members_used = _eemd_members_of_noises(num_noises_used, ensemble_size, complementary);
+	if (ensemble_used != NULL) {
+		*ensemble_used = num_members_used;
+	}
+	if (num_members_used != 1) {
+		const double one_per_ensemble_size = 1.0/num_members_used;
 		array_mult(output, N*M, one_per_ensemble_size);
 	}
-  #ifdef _OPENMP
+	return EMD_SUCCESS;
+}
+
+// Batched EEMD routine definition
+libeemd_error_code eemd_batch(double const* const* inputs, size_t const* N,
+		size_t num_series, double* const* outputs, size_t M,
+		unsigned int ensemble_size, double noise_strength, unsigned int
+		S_number, unsigned int num_siftings, unsigned long int rng_seed, int threads,
+		libeemd_rng rng, bool complementary, double tolerance,
+		unsigned int* ensemble_used, libeemd_precision precision,
+		emd_stopping const* stopping, libeemd_interpolation interpolation,
+		emd_stats* stats, eemd_context* ctx) {
+	gsl_set_error_handler_off();
+	// Validate parameters
+	libeemd_error_code validation_result = validate_eemd_parameters(ensemble_size, noise_strength, S_number, num_siftings, stopping);
+	if (validation_result == EMD_SUCCESS) {
+		validation_result = validate_rng(rng);
+	}
+	if (validation_result == EMD_SUCCESS) {
+		validation_result = validate_precision(precision);
+	}
+	if (validation_result == EMD_SUCCESS) {
+		validation_result = validate_stopping(stopping);
+	}
+	if (validation_result == EMD_SUCCESS) {
+		validation_result = validate_interpolation(interpolation);
+	}
+	if (validation_result != EMD_SUCCESS) {
+		return validation_result;
+	}
+	if (ensemble_used != NULL) {
+		for (size_t series_i=0; series_i<num_series; series_i++) {
+			ensemble_used[series_i] = ensemble_size;
+		}
+	}
+	// The workspaces are allocated for the longest series and reused for all
+	// the others
+	size_t max_N = 0;
+	for (size_t series_i=0; series_i<num_series; series_i++) {
+		if (N[series_i] > max_N) {
+			max_N = N[series_i];
+		}
+	}
+	// For empty data we have nothing to do
+	if (max_N == 0) {
+		return EMD_SUCCESS;
+	}
+	// Use a temporary context if none was given
+	eemd_context* const own_ctx = (ctx == NULL)? allocate_eemd_context() : NULL;
+	if (ctx == NULL) {
+		ctx = own_ctx;
+	}
+	// Number of IMFs, noise level and locks are specific to each series. The
+	// locks of all series are taken from one array of the context.
+	size_t* const Ms = malloc(num_series*sizeof(size_t));
+	double* const noise_sigmas = malloc(num_series*sizeof(double));
+	size_t* const lock_offsets = malloc(num_series*sizeof(size_t));
+	size_t num_locks = 0;
+	size_t max_MN = 0;
+	size_t max_M = 0;
+	for (size_t series_i=0; series_i<num_series; series_i++) {
+		const size_t N_i = N[series_i];
+		Ms[series_i] = (M == 0)? emd_num_imfs(N_i) : M;
+		noise_sigmas[series_i] = (noise_strength != 0 && N_i != 0)?
+			gsl_stats_sd(inputs[series_i], 1, N_i)*noise_strength : 0;
+		// Initialize output data to zero
+		memset(outputs[series_i], 0x00, Ms[series_i]*N_i*sizeof(double));
+		lock_offsets[series_i] = num_locks;
+		num_locks += Ms[series_i];
+		if (Ms[series_i]*N_i > max_MN) {
+			max_MN = Ms[series_i]*N_i;
+		}
+		if (Ms[series_i] > max_M) {
+			max_M = Ms[series_i];
+		}
+	}
+	lock** const locks = get_context_locks(ctx, num_locks);
+	// In complementary EEMD the members are processed in pairs sharing the
+	// same realization of noise
+	const size_t num_noises = complementary? (ensemble_size+1)/2 : ensemble_size;
+	// With an adaptive ensemble size each series keeps adding realizations
+	// of noise until its ensemble mean has converged. The locks of a series
+	// also protect its sums of squares, which are stored like the locks.
+	const bool adaptive = (tolerance > 0 && num_noises > 1);
+	size_t* const noises_used = malloc(num_series*sizeof(size_t));
+	bool* const series_done = malloc(num_series*sizeof(bool));
+	for (size_t series_i=0; series_i<num_series; series_i++) {
+		noises_used[series_i] = num_noises;
+		series_done[series_i] = (N[series_i] == 0);
+	}
+	double* const sumsq = adaptive? get_context_sumsq(ctx, num_locks*max_N) : NULL;
+	if (adaptive) {
+		memset(sumsq, 0x00, num_locks*max_N*sizeof(double));
+	}
+	bool stop_adaptive = false;
+	#ifdef _OPENMP
+	int old_maxthreads = 1;
+	if (threads>0) {
+	  old_maxthreads = omp_get_max_threads();
+	  omp_set_num_threads(threads);    
+	}
+	// Each thread gets a separate workspace if we are using OpenMP
+	const size_t max_threads = (size_t)omp_get_max_threads();
+	#else
+	const size_t max_threads = 1;
+	(void)threads;
+	#endif
+	reserve_context_threads(ctx, max_threads);
+	double* const member_outputs = adaptive? get_context_member_outputs(ctx, max_threads*max_MN) : NULL;
+	libeemd_error_code emd_err = EMD_SUCCESS;
+	// The work is divided into realizations of noise of all series, each used
+	// by one ensemble member or, in complementary EEMD, a pair of them.
+	// Consecutive work items belong to different series, so that threads
+	// working at the same time seldom compete for the same locks.
+	const size_t num_items = num_series*num_noises;
+	// Each thread collects its own statistics if they were requested
+	emd_thread_stats* const thread_stats = (stats != NULL)? allocate_thread_stats(max_threads, max_M) : NULL;
+	size_t team_size = 1;
+	const double start_time = emd_wtime();
+	// The following section is executed in parallel
+	#pragma omp parallel
+	{
+		#ifdef _OPENMP
+	  const size_t thread_id = (size_t)omp_get_thread_num();
+		#pragma omp master
+		team_size = (size_t)omp_get_num_threads();
+		#else
+		const size_t thread_id = 0;
+		#endif
+		// Each thread gets a workspace with room for the longest series
+		eemd_workspace* w = get_context_workspace(ctx, thread_id, max_N, precision);
+		set_eemd_workspace_stats(w, (thread_stats != NULL)? &thread_stats[thread_id] : NULL);
+		set_eemd_workspace_stopping(w, stopping);
+		set_eemd_workspace_interpolation(w, interpolation);
+		if (adaptive) {
+			// The members are decomposed to a private matrix and added to the
+			// output and the sums of squares afterwards. The realizations are
+			// processed in the same rounds as in eemd, skipping the series
+			// that have already converged.
+			set_eemd_workspace_locks(w, NULL);
+			double* const member_output = member_outputs+thread_id*max_MN;
+			for (size_t noise_begin=0; noise_begin<num_noises; noise_begin+=EEMD_CONVERGENCE_INTERVAL) {
+				const size_t noise_end = (noise_begin+EEMD_CONVERGENCE_INTERVAL < num_noises)?
+					noise_begin+EEMD_CONVERGENCE_INTERVAL : num_noises;
+				#pragma omp for schedule(dynamic)
+				for (size_t item_i=noise_begin*num_series; item_i<noise_end*num_series; item_i++) {
+					#pragma omp flush(emd_err)
+					if (emd_err != EMD_SUCCESS) {
+						continue;
+					}
+					const size_t series_i = item_i % num_series;
+					const size_t noise_i = item_i / num_series;
+					if (series_done[series_i]) {
+						continue;
+					}
+					const size_t N_i = N[series_i];
+					const size_t M_i = Ms[series_i];
+					set_eemd_workspace_length(w, N_i);
+					const unsigned int num_members = _eemd_members_per_noise(noise_i, ensemble_size, complementary);
+					memset(member_output, 0x00, M_i*N_i*sizeof(double));
+					libeemd_error_code err = _eemd_ensemble_members(inputs[series_i], N_i,
+							member_output, M_i, noise_sigmas[series_i],
+							S_number, num_siftings, rng_seed, noise_i, num_members, rng, w);
+					if (err != EMD_SUCCESS) {
+						emd_err = err;
+					}
+					else {
+						_eemd_accumulate(member_output, N_i, M_i, outputs[series_i],
+								sumsq+lock_offsets[series_i]*max_N, locks+lock_offsets[series_i], w->stats);
+					}
+					#pragma omp flush(emd_err)
+				}
+				// Check the convergence of each remaining series, see eemd
+				#pragma omp single
+				{
+					stop_adaptive = (emd_err != EMD_SUCCESS);
+					bool all_done = true;
+					for (size_t series_i=0; series_i<num_series; series_i++) {
+						if (series_done[series_i]) {
+							continue;
+						}
+						noises_used[series_i] = noise_end;
+						if (noise_end < num_noises && ensemble_converged(outputs[series_i],
+									sumsq+lock_offsets[series_i]*max_N, N[series_i], Ms[series_i],
+									noise_end, complementary? 2 : 1, tolerance,
+									gsl_stats_sd(inputs[series_i], 1, N[series_i]))) {
+							series_done[series_i] = true;
+						}
+						else {
+							all_done = false;
+						}
+					}
+					stop_adaptive = stop_adaptive || all_done;
+				}
+				if (stop_adaptive) {
+					break;
+				}
+			}
+		}
+		else {
+			#pragma omp for schedule(dynamic)
+			for (size_t item_i=0; item_i<num_items; item_i++) {
+				// Check if an error has occured in other threads
+				#pragma omp flush(emd_err)
+				if (emd_err != EMD_SUCCESS) {
+					continue;
+				}
+				const size_t series_i = item_i % num_series;
+				const size_t noise_i = item_i / num_series;
+				if (N[series_i] == 0) {
+					continue;
+				}
+				set_eemd_workspace_length(w, N[series_i]);
+				set_eemd_workspace_locks(w, locks+lock_offsets[series_i]);
+				const unsigned int num_members = _eemd_members_per_noise(noise_i, ensemble_size, complementary);
+				libeemd_error_code err = _eemd_ensemble_members(inputs[series_i], N[series_i],
+						outputs[series_i], Ms[series_i], noise_sigmas[series_i],
+						S_number, num_siftings, rng_seed, noise_i, num_members, rng, w);
+				if (err != EMD_SUCCESS) {
+					emd_err = err;
+				}
+				#pragma omp flush(emd_err)
+			}
+		}
+	} // End of parallel block
+	#ifdef _OPENMP
 	if (threads>0) {
 	  omp_set_num_threads(old_maxthreads);    
 	}
-  #endif
-	return EMD_SUCCESS;
+	#endif
+	if (stats != NULL) {
+		collect_emd_stats(stats, thread_stats, team_size, emd_wtime()-start_time);
+		free_thread_stats(thread_stats, max_threads);
+	}
+	for (size_t series_i=0; series_i<num_series; series_i++) {
+		// Divide output data by the number of members used to get the average
+		const unsigned int num_members_used = _eemd_members_of_noises(noises_used[series_i], ensemble_size, complementary);
+		if (ensemble_used != NULL) {
+			ensemble_used[series_i] = num_members_used;
+		}
+		if (emd_err == EMD_SUCCESS && num_members_used != 1) {
+			const double one_per_ensemble_size = 1.0/num_members_used;
+			array_mult(outputs[series_i], N[series_i]*Ms[series_i], one_per_ensemble_size);
+		}
+	}
+	// Free resources
+	if (own_ctx != NULL) {
+		free_eemd_context(own_ctx);
+	}
+	free(series_done);
+	free(noises_used);
+	free(lock_offsets);
+	free(noise_sigmas);
+	free(Ms);
+	return emd_err;
 }
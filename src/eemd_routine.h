@@ -27,5 +27,9 @@
 #include "emd.h"
 
 #include "eemd.h"
+#include "context.h"
+#include "philox.h"
+#include "convergence.h"
+#include "numa.h"
 
 #endif // _EEMD_ROUTINE_H_
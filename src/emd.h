@@ -26,6 +26,8 @@
 #include "array.h"
 #include "error.h"
 #include "workspace.h"
+#include "extrema.h"
+#include "spline.h"
 #include "eemd.h"
 
 // This file contains helper functions for doing simple EMD. They are then used
@@ -34,9 +36,43 @@
 // outside libeemd. If you need to compute the ordinary EMD, use the public
 // eemd() routine.
 
+// Number of values of the signal computed by _sift before they are scanned
+// for extrema with extrema_scan_block
+#define EMD_SIFT_BLOCK 256
+
+// Sums over the signal for evaluating the stopping criteria other than the
+// S-number, collected while the envelope mean is subtracted
+typedef struct {
+	// Sums of squares of the envelope mean and of the signal before the
+	// sifting, for EMD_STOP_SD
+	double mean_energy;
+	double signal_energy;
+	// Numbers of points where the envelope mean exceeds theta_1 and theta_2
+	// times the envelope amplitude, for EMD_STOP_RILLING
+	size_t num_above_theta_1;
+	size_t num_above_theta_2;
+} sifting_measures;
+
+// Returns true if the sifting of a signal of length N has converged
+// according to stopping, given the measures of its last envelope mean
+static inline bool sifting_converged(emd_stopping const* stopping,
+		sifting_measures const* measures, size_t N) {
+	switch (stopping->criterion) {
+		case EMD_STOP_SD :
+			return measures->mean_energy <= stopping->sd_limit*measures->signal_energy;
+		case EMD_STOP_RILLING :
+			return measures->num_above_theta_2 == 0 &&
+				(double)measures->num_above_theta_1 <= stopping->alpha*(double)N;
+		default :
+			return false;
+	}
+}
+
 // Helper function for applying the sifting procedure to input until it is
 // reduced to an IMF according to the stopping criteria given by S_number and
-// num_siftings. The required number of siftings is saved to sift_counter.
+// num_siftings, or by w->stopping if it is not NULL. The envelopes are
+// interpolated as given by w->interpolation. The required number of
+// siftings is saved to sift_counter.
 libeemd_error_code _sift(double* __restrict input, sifting_workspace*
 		__restrict w, unsigned int S_number, unsigned int num_siftings,
 		unsigned int* sift_counter);
@@ -48,4 +84,13 @@ libeemd_error_code _emd(double* __restrict input, emd_workspace* __restrict w,
 		double* __restrict output, size_t M,
 		unsigned int S_number, unsigned int num_siftings);
 
+// Single-precision versions of _sift and _emd for float signals. The IMFs
+// are still added to a double output matrix.
+libeemd_error_code _sift_f(float* __restrict input, sifting_workspace_f*
+		__restrict w, unsigned int S_number, unsigned int num_siftings,
+		unsigned int* sift_counter);
+libeemd_error_code _emd_f(float* __restrict input, emd_workspace_f* __restrict w,
+		double* __restrict output, size_t M,
+		unsigned int S_number, unsigned int num_siftings);
+
 #endif // _EEMD_EMD_H_
@@ -0,0 +1,245 @@
+/*
+ ** Precision-generic definitions of _sift and _emd, see precision.h. The
+ ** signal and the workspace have type EMD_REAL, but the IMFs are always
+ ** added to a double output matrix. This file is included by emd.c once for
+ ** each precision, so it has no include guard.
+ */
+
+// Add the contribution of one point to the measures of the envelope mean
+// needed by the stopping criterion
+static inline void EMD_NAME(_measure_envelope_mean)(emd_stopping const* stopping,
+		sifting_measures* measures, EMD_REAL x, EMD_REAL upper, EMD_REAL lower) {
+	const double mean = 0.5*((double)upper + (double)lower);
+	if (stopping->criterion == EMD_STOP_SD) {
+		measures->mean_energy += mean*mean;
+		measures->signal_energy += (double)x*(double)x;
+	}
+	else {
+		const double deviation = fabs(mean);
+		const double amplitude = 0.5*fabs((double)upper - (double)lower);
+		measures->num_above_theta_1 += (deviation > stopping->theta_1*amplitude);
+		measures->num_above_theta_2 += (deviation > stopping->theta_2*amplitude);
+	}
+}
+
+// Subtract the mean of the upper and lower envelopes from input, and find
+// the extrema of the result in the same pass. The envelopes are the
+// interpolants through the current extrema in w, whose coefficients have
+// been solved to w->spline_workspace. The new extrema are stored in the next_* arrays of w,
+// and their numbers to next_num_max and next_num_min. If stopping is not
+// NULL, the measures of the envelope mean needed by its criterion are stored
+// to measures. Returns true if all extrema have the correct signs.
+static bool EMD_NAME(_subtract_envelope_mean)(EMD_REAL* __restrict input, size_t N,
+		EMD_NAME(sifting_workspace)* __restrict w, size_t num_max, size_t num_min,
+		emd_stopping const* stopping, size_t* next_num_max, size_t* next_num_min,
+		sifting_measures* measures) {
+	sifting_measures m = {0, 0, 0, 0};
+	spline_cursor upper;
+	spline_cursor lower;
+	spline_cursor_begin(&upper, w->interpolation, w->maxx, w->maxy, num_max,
+			w->spline_workspace);
+	spline_cursor_begin(&lower, w->interpolation, w->minx, w->miny, num_min,
+			w->spline_workspace+num_max);
+	// The envelopes and the signal are computed in blocks, which are scanned
+	// for extrema while they are still in cache
+	double upper_values[EMD_SIFT_BLOCK];
+	double lower_values[EMD_SIFT_BLOCK];
+	extrema_scan scan;
+	for (size_t b=0; b<N; b+=EMD_SIFT_BLOCK) {
+		const size_t n = (N-b < EMD_SIFT_BLOCK)? N-b : EMD_SIFT_BLOCK;
+		EMD_REAL* const x = input+b;
+		spline_cursor_fill(&upper, b, n, upper_values);
+		spline_cursor_fill(&lower, b, n, lower_values);
+		if (stopping != NULL) {
+			for (size_t k=0; k<n; k++) {
+				EMD_NAME(_measure_envelope_mean)(stopping, &m, x[k], (EMD_REAL)upper_values[k],
+						(EMD_REAL)lower_values[k]);
+			}
+		}
+		for (size_t k=0; k<n; k++) {
+			x[k] = x[k] - (EMD_REAL)0.5*((EMD_REAL)upper_values[k] + (EMD_REAL)lower_values[k]);
+		}
+		if (b == 0) {
+			extrema_scan_begin(&scan, w->next_maxx, w->next_maxy, w->next_minx, w->next_miny, x[0]);
+			EMD_NAME(extrema_scan_block)(&scan, 0, x, n-1);
+		}
+		else {
+			EMD_NAME(extrema_scan_block)(&scan, b-1, x-1, n);
+		}
+	}
+	const bool all_extrema_good = extrema_scan_end(&scan, N, input[N-1]);
+	*next_num_max = scan.num_max;
+	*next_num_min = scan.num_min;
+	*measures = m;
+	return all_extrema_good;
+}
+
+// Make the extrema found by _subtract_envelope_mean the current ones
+static void EMD_NAME(_swap_extrema)(EMD_NAME(sifting_workspace)* w) {
+	double* tmp = w->maxx; w->maxx = w->next_maxx; w->next_maxx = tmp;
+	tmp = w->maxy; w->maxy = w->next_maxy; w->next_maxy = tmp;
+	tmp = w->minx; w->minx = w->next_minx; w->next_minx = tmp;
+	tmp = w->miny; w->miny = w->next_miny; w->next_miny = tmp;
+}
+
+libeemd_error_code EMD_NAME(_sift)(EMD_REAL* __restrict input, EMD_NAME(sifting_workspace)*
+		__restrict w, unsigned int S_number, unsigned int num_siftings,
+		unsigned int* sift_counter) {
+	const size_t N = w->N;
+	emd_thread_stats* const stats = w->stats;
+	// The S-number is used unless another stopping criterion is given
+	emd_stopping const* const stopping =
+		(w->stopping != NULL && w->stopping->criterion != EMD_STOP_S_NUMBER)? w->stopping : NULL;
+	sifting_measures measures;
+	// Initialize counters that keep track of the number of siftings
+	// and the S number
+	*sift_counter = 0;
+	unsigned int S_counter = 0;
+	// Numbers of extrema are initialized to dummy values
+	size_t num_max = (size_t)(-1);
+	size_t num_min = (size_t)(-1);
+	size_t prev_num_max = (size_t)(-1);
+	size_t prev_num_min = (size_t)(-1);
+	// Find the extrema of the input. For the following siftings they are
+	// found while subtracting the envelope mean.
+	double t = (stats != NULL)? emd_wtime() : 0;
+	size_t next_num_max = 0;
+	size_t next_num_min = 0;
+	bool all_extrema_good = EMD_NAME(emd_find_extrema)(input, N, w->maxx, w->maxy,
+			&next_num_max, w->minx, w->miny, &next_num_min);
+	if (stats != NULL) {
+		stats->extrema_time += emd_wtime() - t;
+	}
+	// The spline systems of the previous IMF are not reused
+	w->max_system.N = 0;
+	w->min_system.N = 0;
+	while (num_siftings == 0 || *sift_counter < num_siftings) {
+		(*sift_counter)++;
+	  if (*sift_counter >= 10000) {
+	    return EMD_NO_CONVERGENCE_IN_SIFTING;
+	  }
+		prev_num_max = num_max;
+		prev_num_min = num_min;
+		num_max = next_num_max;
+		num_min = next_num_min;
+		w->num_extrema = num_max + num_min;
+		// Check if we are finished based on the S-number criteria
+		if (stopping == NULL && S_number != 0) {
+		  const int min_diff = abs((int)num_min-(int)prev_num_min);
+		  const int max_diff = abs((int)num_max-(int)prev_num_max);
+		  if ((min_diff + max_diff) <= 1) {
+				S_counter++;
+				if (S_counter >= S_number) {
+				  if (all_extrema_good) {
+						// Number of extrema has been stable for S_number steps
+						// and the extrema have correct signs -- we are converged
+						break;
+					}
+				}
+			}
+			else {
+				S_counter = 0;
+			}
+		}
+		if (stats != NULL) {
+			t = emd_wtime();
+		}
+		// Fit splines, choose order of spline based on the number of extrema.
+		// The coefficients of the lower envelope are stored after those of
+		// the upper envelope. After a swap the next_* arrays hold the
+		// extrema of the previous sifting, for which the spline systems were
+		// eliminated, so the systems are only updated where the extrema
+		// have moved.
+		libeemd_error_code spline_errcode = emd_update_envelope_coefficients(w->interpolation,
+				w->maxx, w->maxy, num_max, w->next_maxx, &w->max_system, w->minx, w->miny,
+				num_min, w->next_minx, &w->min_system, w->spline_workspace);
+		if (spline_errcode != EMD_SUCCESS) {
+			return spline_errcode;
+		}
+		// Subtract envelope mean from the data and find the extrema for the
+		// next sifting
+		all_extrema_good = EMD_NAME(_subtract_envelope_mean)(input, N, w, num_max, num_min,
+				stopping, &next_num_max, &next_num_min, &measures);
+		EMD_NAME(_swap_extrema)(w);
+		if (stats != NULL) {
+			stats->spline_time += emd_wtime() - t;
+		}
+		// Check if the envelope mean that was just subtracted satisfies the
+		// other stopping criteria
+		if (stopping != NULL && sifting_converged(stopping, &measures, N)) {
+			w->num_extrema = next_num_max + next_num_min;
+			break;
+		}
+	}
+	return EMD_SUCCESS;
+}
+
+libeemd_error_code EMD_NAME(_emd)(EMD_REAL* __restrict input, EMD_NAME(emd_workspace)* __restrict w,
+		double* __restrict output, size_t M,
+		unsigned int S_number, unsigned int num_siftings) {
+	// Provide some shorthands to avoid excessive '->' operators
+	const size_t N = w->N;
+	EMD_REAL* const res = w->res;
+	lock** locks = w->locks;
+	emd_thread_stats* const stats = w->sift_w->stats;
+	if (M == 0) {
+		M = emd_num_imfs(N);
+	}
+	// We need to store a copy of the original signal so that once it is
+	// reduced to an IMF we have something to subtract the IMF from to form
+	// the residual for the next iteration
+	EMD_NAME(array_copy)(input, N, res);
+	// Loop over all IMFs to be separated from input
+	unsigned int sift_counter;
+	for (size_t imf_i=0; imf_i<M-1; imf_i++) {
+		if (imf_i != 0) {
+			// Except for the first iteration, restore the previous residual
+			// and use it as an input
+			EMD_NAME(array_copy)(res, N, input);
+		}
+		// Perform siftings on input until it is an IMF
+		libeemd_error_code sift_err = EMD_NAME(_sift)(input, w->sift_w, S_number, num_siftings, &sift_counter);
+		if (sift_err != EMD_SUCCESS) {
+			return sift_err;
+		}
+		// Subtract this IMF from the saved copy to form the residual for
+		// the next round
+		EMD_NAME(array_sub)(input, N, res);
+		double t = 0;
+		if (stats != NULL) {
+			record_sifting(stats, imf_i, sift_counter, w->sift_w->num_extrema);
+			t = emd_wtime();
+		}
+		// Add the discovered IMF to the output matrix. If the output matrix
+		// is shared, use locks to ensure other threads are not writing to the
+		// same row of the output matrix at the same time
+		if (locks != NULL) {
+			get_lock(locks[imf_i]);
+			EMD_NAME(array_add)(input, N, output+N*imf_i);
+			release_lock(locks[imf_i]);
+		}
+		else {
+			EMD_NAME(array_add)(input, N, output+N*imf_i);
+		}
+		if (stats != NULL) {
+			stats->accumulate_time += emd_wtime() - t;
+		}
+		#if EEMD_DEBUG >= 2
+		REprintf("IMF %zd saved after %u siftings.\n", imf_i+1, sift_counter);
+		#endif
+	}
+	// Save final residual
+	const double t = (stats != NULL)? emd_wtime() : 0;
+	if (locks != NULL) {
+		get_lock(locks[M-1]);
+		EMD_NAME(array_add)(res, N, output+N*(M-1));
+		release_lock(locks[M-1]);
+	}
+	else {
+		EMD_NAME(array_add)(res, N, output+N*(M-1));
+	}
+	if (stats != NULL) {
+		stats->accumulate_time += emd_wtime() - t;
+	}
+	return EMD_SUCCESS;
+}
@@ -0,0 +1,140 @@
+/*
+ ** Streaming EMD for Rlibeemd, see emd_stream.h
+ */
+
+#include "emd_stream.h"
+
+emd_stream* allocate_emd_stream(size_t M, size_t margin,
+		unsigned int S_number, unsigned int num_siftings) {
+	emd_stream* s = malloc(sizeof(emd_stream));
+	s->M = M;
+	s->margin = margin;
+	s->S_number = S_number;
+	s->num_siftings = num_siftings;
+	s->capacity = 0;
+	s->buffer = NULL;
+	s->num_context = 0;
+	s->num_pending = 0;
+	s->x = NULL;
+	s->imfs = NULL;
+	s->emd_w = NULL;
+	return s;
+}
+
+void free_emd_stream(emd_stream* s) {
+	if (s->emd_w != NULL) {
+		free_emd_workspace(s->emd_w); s->emd_w = NULL;
+	}
+	free(s->imfs); s->imfs = NULL;
+	free(s->x); s->x = NULL;
+	free(s->buffer); s->buffer = NULL;
+	free(s); s = NULL;
+}
+
+// Make sure the buffers have room for at least 'size' samples. The contents
+// of the sample buffer are preserved.
+static void _emd_stream_reserve(emd_stream* s, size_t size) {
+	if (size <= s->capacity) {
+		return;
+	}
+	// Grow geometrically so that a sequence of growing blocks does not
+	// reallocate every time
+	size_t capacity = 2*s->capacity;
+	if (capacity < size) {
+		capacity = size;
+	}
+	s->buffer = realloc(s->buffer, capacity*sizeof(double));
+	free(s->x);
+	s->x = malloc(capacity*sizeof(double));
+	free(s->imfs);
+	s->imfs = malloc(s->M*capacity*sizeof(double));
+	if (s->emd_w != NULL) {
+		free_emd_workspace(s->emd_w);
+	}
+	s->emd_w = allocate_emd_workspace(capacity);
+	s->capacity = capacity;
+}
+
+// Decompose the current window and emit the IMFs of the num_final oldest
+// pending samples
+static libeemd_error_code _emd_stream_emit(emd_stream* s, size_t num_final,
+		double* __restrict output) {
+	const size_t M = s->M;
+	const size_t N = s->num_context + s->num_pending;
+	memset(s->imfs, 0x00, M*N*sizeof(double));
+	if (N == 1) {
+		// A single sample cannot be sifted, so it is all residual
+		s->imfs[N*(M-1)] = s->buffer[0];
+	}
+	else {
+		array_copy(s->buffer, N, s->x);
+		set_emd_workspace_length(s->emd_w, N);
+		libeemd_error_code emd_err = _emd(s->x, s->emd_w, s->imfs, M,
+				s->S_number, s->num_siftings);
+		if (emd_err != EMD_SUCCESS) {
+			return emd_err;
+		}
+	}
+	for (size_t imf_i=0; imf_i<M; imf_i++) {
+		array_copy(s->imfs+N*imf_i+s->num_context, num_final, output+num_final*imf_i);
+	}
+	s->num_context += num_final;
+	s->num_pending -= num_final;
+	// Keep only the most recent context samples
+	if (s->num_context > s->margin) {
+		const size_t num_dropped = s->num_context - s->margin;
+		memmove(s->buffer, s->buffer+num_dropped, (N-num_dropped)*sizeof(double));
+		s->num_context = s->margin;
+	}
+	return EMD_SUCCESS;
+}
+
+libeemd_error_code emd_stream_append(emd_stream* s, double const* __restrict samples,
+		size_t n, double* __restrict output, size_t* num_output) {
+	*num_output = 0;
+	libeemd_error_code validation_result = validate_eemd_parameters(1, 0, s->S_number, s->num_siftings, NULL);
+	if (validation_result != EMD_SUCCESS) {
+		return validation_result;
+	}
+	if (s->M == 0) {
+		return EMD_INVALID_NUM_IMFS;
+	}
+	if (n == 0) {
+		return EMD_SUCCESS;
+	}
+	const size_t N = s->num_context + s->num_pending;
+	_emd_stream_reserve(s, N+n);
+	array_copy(samples, n, s->buffer+N);
+	s->num_pending += n;
+	// Nothing is final until more than margin samples are pending
+	if (s->num_pending <= s->margin) {
+		return EMD_SUCCESS;
+	}
+	const size_t num_final = s->num_pending - s->margin;
+	libeemd_error_code emit_err = _emd_stream_emit(s, num_final, output);
+	if (emit_err == EMD_SUCCESS) {
+		*num_output = num_final;
+	}
+	return emit_err;
+}
+
+libeemd_error_code emd_stream_flush(emd_stream* s, double* __restrict output,
+		size_t* num_output) {
+	*num_output = 0;
+	libeemd_error_code validation_result = validate_eemd_parameters(1, 0, s->S_number, s->num_siftings, NULL);
+	if (validation_result != EMD_SUCCESS) {
+		return validation_result;
+	}
+	if (s->M == 0) {
+		return EMD_INVALID_NUM_IMFS;
+	}
+	if (s->num_pending == 0) {
+		return EMD_SUCCESS;
+	}
+	const size_t num_final = s->num_pending;
+	libeemd_error_code emit_err = _emd_stream_emit(s, num_final, output);
+	if (emit_err == EMD_SUCCESS) {
+		*num_output = num_final;
+	}
+	return emit_err;
+}
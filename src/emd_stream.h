@@ -0,0 +1,70 @@
+/*
+ ** Streaming EMD for Rlibeemd:
+ ** A stateful decomposer for signals which arrive in blocks. Only a bounded
+ ** window near the right edge of the signal is decomposed again when new
+ ** samples are appended, so the cost of an update depends on the block size
+ ** and the boundary margin, not on the length of the whole signal.
+ */
+
+#ifndef _EEMD_EMD_STREAM_H_
+#define _EEMD_EMD_STREAM_H_
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "array.h"
+#include "error.h"
+#include "workspace.h"
+#include "emd.h"
+#include "eemd.h"
+
+// The state of the stream consists of the most recent raw samples: the
+// context samples, whose IMFs have already been emitted, followed by the
+// pending samples, whose IMFs are still affected by the right edge of the
+// signal. When more than 'margin' samples are pending, the window formed by
+// the context and the pending samples is decomposed with EMD, and the IMF
+// values of the oldest pending samples are emitted as final. At most 'margin'
+// context samples are kept, so that the emitted samples are never closer
+// than 'margin' samples to either edge of the decomposed window, except at
+// the very beginning and end of the stream.
+typedef struct {
+	// Number of IMFs to compute, including the residual
+	size_t M;
+	// Number of samples kept on each side of the emitted samples
+	size_t margin;
+	// Stopping criteria for sifting
+	unsigned int S_number;
+	unsigned int num_siftings;
+	// Number of samples the buffers have room for
+	size_t capacity;
+	// Raw samples: num_context context samples and num_pending pending samples
+	double* buffer;
+	size_t num_context;
+	size_t num_pending;
+	// Copy of the window to be destroyed by EMD and the resulting IMFs
+	double* x;
+	double* imfs;
+	// What is needed for running EMD
+	emd_workspace* emd_w;
+} emd_stream;
+
+emd_stream* allocate_emd_stream(size_t M, size_t margin,
+		unsigned int S_number, unsigned int num_siftings);
+void free_emd_stream(emd_stream* s);
+
+// Append n samples to the stream. The IMFs of the samples which became final
+// are written to output, and their number to num_output. The output is
+// stored in the same format as for eemd, i.e., the values of IMF i start at
+// output+i*(*num_output). The output array needs room for M*n doubles, as at
+// most n samples become final with each call.
+libeemd_error_code emd_stream_append(emd_stream* s, double const* __restrict samples,
+		size_t n, double* __restrict output, size_t* num_output);
+
+// Decompose and emit all pending samples, for example at the end of the
+// signal. The output array needs room for M*margin doubles. Samples appended
+// after this are decomposed using the flushed samples as context.
+libeemd_error_code emd_stream_flush(emd_stream* s, double* __restrict output,
+		size_t* num_output);
+
+#endif // _EEMD_EMD_STREAM_H_
@@ -0,0 +1,60 @@
+#include <Rcpp.h>
+
+extern "C"
+{
+  #include "emd_stream.h"
+}
+
+using namespace Rcpp;
+
+static void finalize_emd_stream(emd_stream* s) {
+  free_emd_stream(s);
+}
+
+typedef XPtr<emd_stream, PreserveStorage, finalize_emd_stream, true> emd_stream_ptr;
+
+// Copy the output of the stream to a matrix with one column per IMF
+static NumericMatrix stream_output(const std::vector<double>& output, size_t num_output, size_t M) {
+  NumericMatrix result(static_cast<int>(num_output), static_cast<int>(M));
+  std::copy(output.begin(), output.begin() + num_output * M, result.begin());
+  return result;
+}
+
+// [[Rcpp::export]]
+SEXP emd_stream_createR(double num_imfs, double margin = 256, unsigned int S_number = 4, 
+unsigned int num_siftings = 50){
+  
+  emd_stream* s = allocate_emd_stream((size_t)num_imfs, (size_t)margin, S_number, num_siftings);
+  return emd_stream_ptr(s, true);
+}
+
+// [[Rcpp::export]]
+NumericMatrix emd_stream_appendR(SEXP stream, NumericVector x){
+  
+  emd_stream_ptr s(stream);
+  emd_stream* ptr = s.checked_get();
+  size_t n = x.size();
+  std::vector<double> output(ptr->M * n);
+  size_t num_output = 0;
+  libeemd_error_code err = emd_stream_append(ptr, x.begin(), n, output.data(), &num_output);
+  
+  if(err!=EMD_SUCCESS){
+    printError(err);
+  }
+  return stream_output(output, num_output, ptr->M);
+}
+
+// [[Rcpp::export]]
+NumericMatrix emd_stream_flushR(SEXP stream){
+  
+  emd_stream_ptr s(stream);
+  emd_stream* ptr = s.checked_get();
+  std::vector<double> output(ptr->M * ptr->margin);
+  size_t num_output = 0;
+  libeemd_error_code err = emd_stream_flush(ptr, output.data(), &num_output);
+  
+  if(err!=EMD_SUCCESS){
+    printError(err);
+  }
+  return stream_output(output, num_output, ptr->M);
+}
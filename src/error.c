@@ -20,7 +20,7 @@
 
 #include "error.h"
 
-libeemd_error_code validate_eemd_parameters(unsigned int ensemble_size, double noise_strength, unsigned int S_number, unsigned int num_siftings) {
+libeemd_error_code validate_eemd_parameters(unsigned int ensemble_size, double noise_strength, unsigned int S_number, unsigned int num_siftings, emd_stopping const* stopping) {
 	if (ensemble_size < 1) {
 		return EMD_INVALID_ENSEMBLE_SIZE;
 	}
@@ -33,12 +33,63 @@ libeemd_error_code validate_eemd_parameters(unsigned int ensemble_size, double n
 	if (ensemble_size > 1 && noise_strength == 0) {
 		return EMD_NO_NOISE_ADDED_TO_EEMD;
 	}
-	if (S_number == 0 && num_siftings == 0) {
+	const bool S_number_used = (stopping == NULL || stopping->criterion == EMD_STOP_S_NUMBER);
+	if (S_number_used && S_number == 0 && num_siftings == 0) {
 		return EMD_NO_CONVERGENCE_POSSIBLE;
 	}
 	return EMD_SUCCESS;
 }
 
+libeemd_error_code validate_rng(libeemd_rng rng) {
+	if (rng != EMD_RNG_MT19937 && rng != EMD_RNG_PHILOX) {
+		return EMD_INVALID_RNG;
+	}
+	return EMD_SUCCESS;
+}
+
+libeemd_error_code validate_precision(libeemd_precision precision) {
+	if (precision != EMD_DOUBLE && precision != EMD_FLOAT) {
+		return EMD_INVALID_PRECISION;
+	}
+	return EMD_SUCCESS;
+}
+
+libeemd_error_code validate_affinity(libeemd_affinity affinity) {
+	if (affinity != EMD_AFFINITY_NONE && affinity != EMD_AFFINITY_NUMA &&
+			affinity != EMD_AFFINITY_PIN) {
+		return EMD_INVALID_AFFINITY;
+	}
+	return EMD_SUCCESS;
+}
+
+libeemd_error_code validate_stopping(emd_stopping const* stopping) {
+	if (stopping == NULL) {
+		return EMD_SUCCESS;
+	}
+	switch (stopping->criterion) {
+		case EMD_STOP_S_NUMBER :
+			return EMD_SUCCESS;
+		case EMD_STOP_SD :
+			return (stopping->sd_limit > 0)? EMD_SUCCESS : EMD_INVALID_STOPPING;
+		case EMD_STOP_RILLING :
+			if (stopping->theta_1 > 0 && stopping->theta_2 >= stopping->theta_1 &&
+					stopping->alpha >= 0 && stopping->alpha < 1) {
+				return EMD_SUCCESS;
+			}
+			return EMD_INVALID_STOPPING;
+		default :
+			return EMD_INVALID_STOPPING;
+	}
+}
+
+libeemd_error_code validate_interpolation(libeemd_interpolation interpolation) {
+	if (interpolation != EMD_INTERP_SPLINE && interpolation != EMD_INTERP_LINEAR &&
+			interpolation != EMD_INTERP_PCHIP && interpolation != EMD_INTERP_AKIMA) {
+		return EMD_INVALID_INTERPOLATION;
+	}
+	return EMD_SUCCESS;
+}
+
 //*** Removed in Rlibeemd ***//
 
 /*
@@ -80,4 +131,4 @@ void emd_report_to_file_if_error(FILE* file, libeemd_error_code err) {
 void emd_report_if_error(libeemd_error_code err) {
 	emd_report_to_file_if_error(stderr, err);
 }
-*/
\ No newline at end of file
+*/
\ No newline at end of file
@@ -21,6 +21,11 @@
 
 #include "eemd.h"
 
-libeemd_error_code validate_eemd_parameters(unsigned int ensemble_size, double noise_strength, unsigned int S_number, unsigned int num_siftings);
+libeemd_error_code validate_eemd_parameters(unsigned int ensemble_size, double noise_strength, unsigned int S_number, unsigned int num_siftings, emd_stopping const* stopping);
+libeemd_error_code validate_rng(libeemd_rng rng);
+libeemd_error_code validate_precision(libeemd_precision precision);
+libeemd_error_code validate_affinity(libeemd_affinity affinity);
+libeemd_error_code validate_stopping(emd_stopping const* stopping);
+libeemd_error_code validate_interpolation(libeemd_interpolation interpolation);
 
 #endif // _EEMD_ERROR_H_
@@ -32,7 +32,14 @@ typedef enum {
   EMD_INVALID_SPLINE_POINTS = 7,
   // Other errors
   EMD_GSL_ERROR = 8,
-  EMD_NO_CONVERGENCE_IN_SIFTING = 9
+  EMD_NO_CONVERGENCE_IN_SIFTING = 9,
+  EMD_INVALID_NUM_IMFS = 10,
+  EMD_INVALID_RNG = 11,
+  EMD_INVALID_PRECISION = 12,
+  EMD_INVALID_AFFINITY = 13,
+  EMD_INVALID_STOPPING = 14,
+  EMD_INVALID_INTERPOLATION = 15,
+  EMD_INVALID_NOISE_CACHE = 16
 } libeemd_error_code;
 
 
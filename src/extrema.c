@@ -16,104 +16,160 @@
  * along with libeemd.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdint.h>
+
 #include "extrema.h"
 
-bool emd_find_extrema(double const* __restrict x, size_t N,
-  double* __restrict maxx, double* __restrict maxy, size_t* nmax,
-  double* __restrict minx, double* __restrict miny, size_t* nmin) {
-  // Set the number of extrema to zero initially
-  *nmax = 0;
-  *nmin = 0;
-  // Handle empty array as a special case
-  if (N == 0) {
-    return true;
+#if defined(__SSE2__) || defined(__AVX__) || defined(__AVX512F__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// Set bit k of up if x[k+1] > x[k] and bit k of down if x[k+1] < x[k], for
+// k < n <= EXTREMA_BLOCK. The comparisons are done for whole vectors with the
+// widest instruction set enabled at compile time, and the remainder with
+// scalar code. As with the scalar comparisons, a NaN is neither up nor down.
+static inline void extrema_slope_masks(double const* __restrict x, size_t n,
+    uint64_t* up, uint64_t* down) {
+  uint64_t u = 0;
+  uint64_t d = 0;
+  size_t k = 0;
+#if defined(__AVX512F__)
+  for (; k+8<=n; k+=8) {
+    const __m512d a = _mm512_loadu_pd(x+k);
+    const __m512d b = _mm512_loadu_pd(x+k+1);
+    u |= (uint64_t)_mm512_cmp_pd_mask(b, a, _CMP_GT_OQ) << k;
+    d |= (uint64_t)_mm512_cmp_pd_mask(b, a, _CMP_LT_OQ) << k;
   }
-  // Add the ends of the data as both local minima and maxima. These
-  // might be changed later by linear extrapolation.
-  maxx[0] = 0;
-  maxy[0] = x[0];
-  (*nmax)++;
-  minx[0] = 0;
-  miny[0] = x[0];
-  (*nmin)++;
-  // If we had only one data point this is it
-  if (N == 1) {
-    return true;
+#elif defined(__AVX__)
+  for (; k+4<=n; k+=4) {
+    const __m256d a = _mm256_loadu_pd(x+k);
+    const __m256d b = _mm256_loadu_pd(x+k+1);
+    u |= (uint64_t)_mm256_movemask_pd(_mm256_cmp_pd(b, a, _CMP_GT_OQ)) << k;
+    d |= (uint64_t)_mm256_movemask_pd(_mm256_cmp_pd(b, a, _CMP_LT_OQ)) << k;
+  }
+#elif defined(__SSE2__)
+  for (; k+2<=n; k+=2) {
+    const __m128d a = _mm_loadu_pd(x+k);
+    const __m128d b = _mm_loadu_pd(x+k+1);
+    u |= (uint64_t)_mm_movemask_pd(_mm_cmpgt_pd(b, a)) << k;
+    d |= (uint64_t)_mm_movemask_pd(_mm_cmplt_pd(b, a)) << k;
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  static const uint64_t lane_bits[2] = {1, 2};
+  const uint64x2_t bits = vld1q_u64(lane_bits);
+  for (; k+2<=n; k+=2) {
+    const float64x2_t a = vld1q_f64(x+k);
+    const float64x2_t b = vld1q_f64(x+k+1);
+    u |= vaddvq_u64(vandq_u64(vcgtq_f64(b, a), bits)) << k;
+    d |= vaddvq_u64(vandq_u64(vcltq_f64(b, a), bits)) << k;
   }
-  // Now starts the main extrema-finding loop. The loop detects points where
-  // the slope of the data changes sign. In the case of flat regions at the
-  // extrema, the center point of the flat region will be considered the
-  // extremal point. While detecting extrema, the loop also counts the number
-  // of zero crossings that occur.
-  bool all_extrema_good = true;
-  enum slope { UP, DOWN, NONE };
-  enum slope previous_slope = NONE;
-  int flat_counter = 0;
-  for (size_t i=0; i<N-1; i++) {
-    if (x[i+1] > x[i]) { // Going up
-      if (previous_slope == DOWN) {
-        // Was going down before -> local minimum found
-        minx[*nmin] = (double)(i)-(double)(flat_counter)/2;
-        miny[*nmin] = x[i];
-        (*nmin)++;
-        if (x[i] >= 0) { // minima need to be negative
-          all_extrema_good = false;
-        }
-      }
-      previous_slope = UP;
-      flat_counter = 0;
-    }
-    
-    else if (x[i+1] < x[i]) { // Going down
-      if (previous_slope == UP) {
-        // Was going up before -> local maximum found
-        maxx[*nmax] = (double)(i)-(double)(flat_counter)/2;
-        maxy[*nmax] = x[i];
-        (*nmax)++;
-        if (x[i] <= 0) { // maxima need to be positive
-          all_extrema_good = false;
-        }
-      }
-      previous_slope = DOWN;
-      flat_counter = 0;
-    }
-    else { // Staying flat
-      flat_counter++;
-#if EEMD_DEBUG >= 3
-      REprintf("Warning: a flat slope found in data. The results will differ from the reference EEMD implementation.\n");
 #endif
-    }
+  for (; k<n; k++) {
+    u |= (uint64_t)(x[k+1] > x[k]) << k;
+    d |= (uint64_t)(x[k+1] < x[k]) << k;
+  }
+  *up = u;
+  *down = d;
+}
+
+static inline void extrema_slope_masks_f(float const* __restrict x, size_t n,
+    uint64_t* up, uint64_t* down) {
+  uint64_t u = 0;
+  uint64_t d = 0;
+  size_t k = 0;
+#if defined(__AVX512F__)
+  for (; k+16<=n; k+=16) {
+    const __m512 a = _mm512_loadu_ps(x+k);
+    const __m512 b = _mm512_loadu_ps(x+k+1);
+    u |= (uint64_t)_mm512_cmp_ps_mask(b, a, _CMP_GT_OQ) << k;
+    d |= (uint64_t)_mm512_cmp_ps_mask(b, a, _CMP_LT_OQ) << k;
+  }
+#elif defined(__AVX__)
+  for (; k+8<=n; k+=8) {
+    const __m256 a = _mm256_loadu_ps(x+k);
+    const __m256 b = _mm256_loadu_ps(x+k+1);
+    u |= (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(b, a, _CMP_GT_OQ)) << k;
+    d |= (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(b, a, _CMP_LT_OQ)) << k;
+  }
+#elif defined(__SSE2__)
+  for (; k+4<=n; k+=4) {
+    const __m128 a = _mm_loadu_ps(x+k);
+    const __m128 b = _mm_loadu_ps(x+k+1);
+    u |= (uint64_t)_mm_movemask_ps(_mm_cmpgt_ps(b, a)) << k;
+    d |= (uint64_t)_mm_movemask_ps(_mm_cmplt_ps(b, a)) << k;
   }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  static const uint32_t lane_bits[4] = {1, 2, 4, 8};
+  const uint32x4_t bits = vld1q_u32(lane_bits);
+  for (; k+4<=n; k+=4) {
+    const float32x4_t a = vld1q_f32(x+k);
+    const float32x4_t b = vld1q_f32(x+k+1);
+    u |= (uint64_t)vaddvq_u32(vandq_u32(vcgtq_f32(b, a), bits)) << k;
+    d |= (uint64_t)vaddvq_u32(vandq_u32(vcltq_f32(b, a), bits)) << k;
+  }
+#endif
+  for (; k<n; k++) {
+    u |= (uint64_t)(x[k+1] > x[k]) << k;
+    d |= (uint64_t)(x[k+1] < x[k]) << k;
+  }
+  *up = u;
+  *down = d;
+}
+
+#define EMD_REAL double
+#define EMD_SUFFIX
+#include "extrema_impl.h"
+#undef EMD_SUFFIX
+#undef EMD_REAL
+#define EMD_REAL float
+#define EMD_SUFFIX _f
+#include "extrema_impl.h"
+#undef EMD_SUFFIX
+#undef EMD_REAL
+
+bool extrema_scan_end(extrema_scan* s, size_t N, double x_last) {
+  // If we had only one data point the beginning is also the end
+  if (N <= 1) {
+    return s->all_extrema_good;
+  }
+  double* const maxx = s->maxx;
+  double* const maxy = s->maxy;
+  double* const minx = s->minx;
+  double* const miny = s->miny;
   // Add the other end of the data as extrema as well.
-  maxx[*nmax] = (double)(N-1);
-  maxy[*nmax] = x[N-1];
-  (*nmax)++;
-  minx[*nmin] = (double)(N-1);
-  miny[*nmin] = x[N-1];
-  (*nmin)++;
+  maxx[s->num_max] = (double)(N-1);
+  maxy[s->num_max] = x_last;
+  s->num_max++;
+  minx[s->num_min] = (double)(N-1);
+  miny[s->num_min] = x_last;
+  s->num_min++;
+  const size_t nmax = s->num_max;
+  const size_t nmin = s->num_min;
   // If we have at least two interior extrema, test if linear extrapolation provides
   // a more extremal value.
-  if (*nmax >= 4) {
+  if (nmax >= 4) {
     const double max_el = linear_extrapolate(maxx[1], maxy[1],
       maxx[2], maxy[2], 0);
     if (max_el > maxy[0])
       maxy[0] = max_el;
-    const double max_er = linear_extrapolate(maxx[*nmax-3], maxy[*nmax-3],
-      maxx[*nmax-2], maxy[*nmax-2], (double)(N-1));
-    if (max_er > maxy[*nmax-1])
-      maxy[*nmax-1] = max_er;
+    const double max_er = linear_extrapolate(maxx[nmax-3], maxy[nmax-3],
+      maxx[nmax-2], maxy[nmax-2], (double)(N-1));
+    if (max_er > maxy[nmax-1])
+      maxy[nmax-1] = max_er;
   }
-  if (*nmin >= 4) {
+  if (nmin >= 4) {
     const double min_el = linear_extrapolate(minx[1], miny[1],
       minx[2], miny[2], 0);
     if (min_el < miny[0])
       miny[0] = min_el;
-    const double min_er = linear_extrapolate(minx[*nmin-3], miny[*nmin-3],
-      minx[*nmin-2], miny[*nmin-2], (double)(N-1));
-    if (min_er < miny[*nmin-1])
-      miny[*nmin-1] = min_er;
+    const double min_er = linear_extrapolate(minx[nmin-3], miny[nmin-3],
+      minx[nmin-2], miny[nmin-2], (double)(N-1));
+    if (min_er < miny[nmin-1])
+      miny[nmin-1] = min_er;
   }
-  return all_extrema_good;
+  return s->all_extrema_good;
 }
 
 void emd_find_maxima(double const* __restrict x, size_t N, double* __restrict maxx, double* __restrict maxy, size_t* nmax) {
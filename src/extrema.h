@@ -20,9 +20,12 @@
 #define _EEMD_EXTREMA_H_
 
 #include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <assert.h>
 
 #include "eemd.h"
+#include "precision.h"
 
 // Helper function for extrapolating data at the ends. For a line passing
 // through (x0, y0), (x1, y1), and (x, y), return y for a given x.
@@ -32,6 +35,114 @@ static inline double linear_extrapolate(double x0, double y0,
 	return y0 + (y1-y0)*(x-x0)/(x1-x0);
 }
 
+// Incremental version of emd_find_extrema, which finds the extrema of a
+// signal while it is being computed. After extrema_scan_begin with the first
+// value of the signal, extrema_scan_step is called for each pair of
+// consecutive values x_i and x_{i+1}, and extrema_scan_end adds the end
+// points. The results are identical to emd_find_extrema.
+typedef struct {
+	double* maxx;
+	double* maxy;
+	size_t num_max;
+	double* minx;
+	double* miny;
+	size_t num_min;
+	// Slope of the previous step: 1 for up, -1 for down and 0 for none
+	int previous_slope;
+	int flat_counter;
+	bool all_extrema_good;
+} extrema_scan;
+
+static inline void extrema_scan_begin(extrema_scan* s, double* __restrict maxx,
+		double* __restrict maxy, double* __restrict minx, double* __restrict miny,
+		double x_0) {
+	s->maxx = maxx;
+	s->maxy = maxy;
+	s->minx = minx;
+	s->miny = miny;
+	// Add the beginning of the data as both local minimum and maximum. These
+	// might be changed later by linear extrapolation.
+	maxx[0] = 0;
+	maxy[0] = x_0;
+	s->num_max = 1;
+	minx[0] = 0;
+	miny[0] = x_0;
+	s->num_min = 1;
+	s->previous_slope = 0;
+	s->flat_counter = 0;
+	s->all_extrema_good = true;
+}
+
+// Detect a change of the sign of the slope between x_i and x_next. In the
+// case of flat regions at the extrema, the center point of the flat region
+// will be considered the extremal point.
+static inline void extrema_scan_step(extrema_scan* s, size_t i, double x_i, double x_next) {
+	if (x_next > x_i) { // Going up
+		if (s->previous_slope == -1) {
+			// Was going down before -> local minimum found
+			s->minx[s->num_min] = (double)(i)-(double)(s->flat_counter)/2;
+			s->miny[s->num_min] = x_i;
+			s->num_min++;
+			if (x_i >= 0) { // minima need to be negative
+				s->all_extrema_good = false;
+			}
+		}
+		s->previous_slope = 1;
+		s->flat_counter = 0;
+	}
+	else if (x_next < x_i) { // Going down
+		if (s->previous_slope == 1) {
+			// Was going up before -> local maximum found
+			s->maxx[s->num_max] = (double)(i)-(double)(s->flat_counter)/2;
+			s->maxy[s->num_max] = x_i;
+			s->num_max++;
+			if (x_i <= 0) { // maxima need to be positive
+				s->all_extrema_good = false;
+			}
+		}
+		s->previous_slope = -1;
+		s->flat_counter = 0;
+	}
+	else { // Staying flat
+		s->flat_counter++;
+	}
+}
+
+// Number of pairs of consecutive values whose slopes are stored in the bits
+// of one mask by extrema_slope_masks
+#define EXTREMA_BLOCK 64
+
+// Index of the lowest set bit of a nonzero mask
+static inline unsigned int extrema_ctz(uint64_t mask) {
+#if defined(__GNUC__)
+	return (unsigned int)__builtin_ctzll(mask);
+#else
+	unsigned int k = 0;
+	while ((mask & 1) == 0) {
+		mask >>= 1;
+		k++;
+	}
+	return k;
+#endif
+}
+
+// Equivalent to calling extrema_scan_step for the n pairs of consecutive
+// values of x, where x[0] has index i in the signal, so x must have n+1
+// values. The slopes of whole blocks are compared as vectors, and only blocks
+// with flat regions go through extrema_scan_step.
+void extrema_scan_block(extrema_scan* s, size_t i, double const* __restrict x, size_t n);
+void extrema_scan_block_f(extrema_scan* s, size_t i, float const* __restrict x, size_t n);
+
+// Add the end of the signal of length N with last value x_last as both
+// extrema, and return whether all extrema had the correct sign
+bool extrema_scan_end(extrema_scan* s, size_t N, double x_last);
+
+// Version of emd_find_extrema for a float signal. The extrema are stored as
+// doubles as usual.
+bool emd_find_extrema_f(float const* __restrict x, size_t N,
+		double* __restrict maxx, double* __restrict maxy, size_t* num_max,
+		double* __restrict minx, double* __restrict miny, size_t* num_min);
+
 // Provide a maxima-only version for BEMD. This leads to code duplication but
 // making emd_find_extrema more generic would slow down other EMD functions.
 void emd_find_maxima(double const* __restrict x, size_t N, double* __restrict maxx, double* __restrict maxy, size_t* num_max_ptr);
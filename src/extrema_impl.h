@@ -0,0 +1,72 @@
+/*
+ ** Precision-generic definition of emd_find_extrema, see precision.h. The
+ ** signal has type EMD_REAL, but the extrema are always stored as doubles.
+ ** This file is included by extrema.c once for each precision, so it has no
+ ** include guard.
+ */
+
+bool EMD_NAME(emd_find_extrema)(EMD_REAL const* __restrict x, size_t N,
+  double* __restrict maxx, double* __restrict maxy, size_t* nmax,
+  double* __restrict minx, double* __restrict miny, size_t* nmin) {
+  // Set the number of extrema to zero initially
+  *nmax = 0;
+  *nmin = 0;
+  // Handle empty array as a special case
+  if (N == 0) {
+    return true;
+  }
+  // Now starts the main extrema-finding loop. The loop detects points where
+  // the slope of the data changes sign, see extrema_scan_step.
+  extrema_scan s;
+  extrema_scan_begin(&s, maxx, maxy, minx, miny, x[0]);
+  EMD_NAME(extrema_scan_block)(&s, 0, x, N-1);
+  const bool all_extrema_good = extrema_scan_end(&s, N, x[N-1]);
+  *nmax = s.num_max;
+  *nmin = s.num_min;
+  return all_extrema_good;
+}
+
+void EMD_NAME(extrema_scan_block)(extrema_scan* s, size_t i, EMD_REAL const* __restrict x,
+    size_t n) {
+  for (size_t b=0; b<n; b+=EXTREMA_BLOCK) {
+    const size_t m = (n-b < EXTREMA_BLOCK)? n-b : EXTREMA_BLOCK;
+    EMD_REAL const* const xb = x+b;
+    uint64_t up;
+    uint64_t down;
+    EMD_NAME(extrema_slope_masks)(xb, m, &up, &down);
+    const uint64_t all = (m == EXTREMA_BLOCK)? ~(uint64_t)0 : ((uint64_t)1 << m)-1;
+    if ((up | down) != all || s->flat_counter != 0) {
+      // The extrema of flat regions are placed at their centers, which is
+      // left to the state machine
+      for (size_t k=0; k<m; k++) {
+        extrema_scan_step(s, i+b+k, xb[k], xb[k+1]);
+      }
+      continue;
+    }
+    // Without flat regions the extrema are the points where the slope
+    // changes sign. The slope before the block is the previous slope.
+    const uint64_t up_before = (up << 1) | (uint64_t)(s->previous_slope == 1);
+    const uint64_t down_before = (down << 1) | (uint64_t)(s->previous_slope == -1);
+    uint64_t minima = up & down_before;
+    uint64_t maxima = down & up_before;
+    bool all_extrema_good = s->all_extrema_good;
+    while (minima != 0) {
+      const unsigned int k = extrema_ctz(minima);
+      minima &= minima-1;
+      s->minx[s->num_min] = (double)(i+b+k);
+      s->miny[s->num_min] = xb[k];
+      s->num_min++;
+      all_extrema_good &= !(xb[k] >= 0); // minima need to be negative
+    }
+    while (maxima != 0) {
+      const unsigned int k = extrema_ctz(maxima);
+      maxima &= maxima-1;
+      s->maxx[s->num_max] = (double)(i+b+k);
+      s->maxy[s->num_max] = xb[k];
+      s->num_max++;
+      all_extrema_good &= !(xb[k] <= 0); // maxima need to be positive
+    }
+    s->all_extrema_good = all_extrema_good;
+    s->previous_slope = ((up >> (m-1)) & 1)? 1 : -1;
+  }
+}
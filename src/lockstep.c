@@ -0,0 +1,361 @@
+/*
+ ** Lock-step extrema and envelopes of several signals for Rlibeemd, see
+ ** lockstep.h. Each loop over the lanes below corresponds to one statement
+ ** of the scalar code in extrema.h and spline.c, and evaluates the same
+ ** expressions in the same order, so that the lanes get exactly the same
+ ** values as the scalar code. Lanes for which a statement does not apply
+ ** compute it anyway and discard the result.
+ */
+
+#include <string.h>
+
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_poly.h>
+
+#include "lockstep.h"
+#include "emd.h"
+
+#define LANES EMD_LOCKSTEP_LANES
+
+static lockstep_workspace* _take_lockstep_workspace(emd_arena* a, size_t N) {
+	lockstep_workspace* w = emd_arena_take(a, 1, sizeof(lockstep_workspace));
+	// As in sifting_workspace, there are at most N/2+2 extrema of each kind
+	const size_t max_extrema = N/2+2;
+	const size_t knots = LANES*max_extrema;
+	double* const x = emd_arena_take(a, LANES*N, sizeof(double));
+	double* extrema[8];
+	for (size_t k=0; k<8; k++) {
+		extrema[k] = emd_arena_take(a, knots, sizeof(double));
+	}
+	double* splines[6];
+	for (size_t k=0; k<6; k++) {
+		splines[k] = emd_arena_take(a, knots, sizeof(double));
+	}
+	if (w == NULL) {
+		return NULL;
+	}
+	w->N = N;
+	w->max_extrema = max_extrema;
+	w->x = x;
+	w->maxx = extrema[0];
+	w->maxy = extrema[1];
+	w->minx = extrema[2];
+	w->miny = extrema[3];
+	w->next_maxx = extrema[4];
+	w->next_maxy = extrema[5];
+	w->next_minx = extrema[6];
+	w->next_miny = extrema[7];
+	w->max_c = splines[0];
+	w->knot_x = splines[1];
+	w->knot_y = splines[2];
+	w->knot_c = splines[3];
+	w->pivots = splines[4];
+	w->multipliers = splines[5];
+	for (size_t k=0; k<LANES; k++) {
+		w->next_num_max[k] = 0;
+		w->next_num_min[k] = 0;
+	}
+	return w;
+}
+
+lockstep_workspace* allocate_lockstep_workspace(size_t N) {
+	emd_arena a = emd_arena_sizing();
+	_take_lockstep_workspace(&a, N);
+	if (!emd_arena_allocate(&a)) {
+		return NULL;
+	}
+	// The arrays are zeroed, since the lanes that are not used are
+	// computed with the others
+	memset(a.memory, 0, a.size);
+	lockstep_workspace* w = _take_lockstep_workspace(&a, N);
+	w->arena = a;
+	return w;
+}
+
+void free_lockstep_workspace(lockstep_workspace* w) {
+	emd_arena a = w->arena;
+	emd_arena_free(&a);
+}
+
+// Begin the extrema scans of all lanes to the next_* arrays of w
+static void _lockstep_scan_begin(lockstep_workspace* w, extrema_scan* scan) {
+	for (size_t k=0; k<LANES; k++) {
+		const size_t offset = k*w->max_extrema;
+		extrema_scan_begin(&scan[k], w->next_maxx+offset, w->next_maxy+offset,
+				w->next_minx+offset, w->next_miny+offset, w->x[k]);
+	}
+}
+
+// Version of extrema_scan_block for the n pairs of consecutive values of all
+// lanes starting from index i. The slope masks of a block are formed for all
+// lanes in the same loop over its points, and the extrema of each lane are
+// then read from its masks as in extrema_scan_block.
+static void _lockstep_scan(lockstep_workspace* w, extrema_scan* scan, size_t i, size_t n) {
+	for (size_t b=0; b<n; b+=EXTREMA_BLOCK) {
+		const size_t m = (n-b < EXTREMA_BLOCK)? n-b : EXTREMA_BLOCK;
+		double const* const xb = w->x + (i+b)*LANES;
+		uint64_t up[LANES];
+		uint64_t down[LANES];
+		for (size_t k=0; k<LANES; k++) {
+			up[k] = 0;
+			down[k] = 0;
+		}
+		for (size_t q=0; q<m; q++) {
+			double const* const x_q = xb + q*LANES;
+			#pragma omp simd
+			for (size_t k=0; k<LANES; k++) {
+				up[k] |= (uint64_t)(x_q[LANES+k] > x_q[k]) << q;
+				down[k] |= (uint64_t)(x_q[LANES+k] < x_q[k]) << q;
+			}
+		}
+		const uint64_t all = (m == EXTREMA_BLOCK)? ~(uint64_t)0 : ((uint64_t)1 << m)-1;
+		for (size_t k=0; k<LANES; k++) {
+			extrema_scan* const s = &scan[k];
+			double const* const x = xb + k;
+			if ((up[k] | down[k]) != all || s->flat_counter != 0) {
+				for (size_t q=0; q<m; q++) {
+					extrema_scan_step(s, i+b+q, x[q*LANES], x[(q+1)*LANES]);
+				}
+				continue;
+			}
+			const uint64_t up_before = (up[k] << 1) | (uint64_t)(s->previous_slope == 1);
+			const uint64_t down_before = (down[k] << 1) | (uint64_t)(s->previous_slope == -1);
+			uint64_t minima = up[k] & down_before;
+			uint64_t maxima = down[k] & up_before;
+			bool all_extrema_good = s->all_extrema_good;
+			while (minima != 0) {
+				const unsigned int q = extrema_ctz(minima);
+				minima &= minima-1;
+				s->minx[s->num_min] = (double)(i+b+q);
+				s->miny[s->num_min] = x[q*LANES];
+				s->num_min++;
+				all_extrema_good &= !(x[q*LANES] >= 0);
+			}
+			while (maxima != 0) {
+				const unsigned int q = extrema_ctz(maxima);
+				maxima &= maxima-1;
+				s->maxx[s->num_max] = (double)(i+b+q);
+				s->maxy[s->num_max] = x[q*LANES];
+				s->num_max++;
+				all_extrema_good &= !(x[q*LANES] <= 0);
+			}
+			s->all_extrema_good = all_extrema_good;
+			s->previous_slope = ((up[k] >> (m-1)) & 1)? 1 : -1;
+		}
+	}
+}
+
+// Finish the extrema scans of all lanes, storing the numbers of extrema to
+// w->next_num_max and w->next_num_min and whether all extrema of each lane
+// have the correct signs to all_extrema_good
+static void _lockstep_scan_end(lockstep_workspace* w, extrema_scan* scan,
+		bool* all_extrema_good) {
+	const size_t N = w->N;
+	for (size_t k=0; k<LANES; k++) {
+		all_extrema_good[k] = extrema_scan_end(&scan[k], N, w->x[(N-1)*LANES+k]);
+		w->next_num_max[k] = scan[k].num_max;
+		w->next_num_min[k] = scan[k].num_min;
+	}
+}
+
+// Find the extrema of all lanes to the next_* arrays of w, see
+// emd_find_extrema
+static void _lockstep_find_extrema(lockstep_workspace* w, bool* all_extrema_good) {
+	const size_t N = w->N;
+	extrema_scan scan[LANES];
+	_lockstep_scan_begin(w, scan);
+	for (size_t i=0; i+1<N; i+=EMD_SIFT_BLOCK) {
+		const size_t n = (N-1-i < EMD_SIFT_BLOCK)? N-1-i : EMD_SIFT_BLOCK;
+		_lockstep_scan(w, scan, i, n);
+	}
+	_lockstep_scan_end(w, scan, all_extrema_good);
+}
+
+// Make the extrema found by the last scan the current ones
+static void _lockstep_swap_extrema(lockstep_workspace* w) {
+	double* tmp = w->maxx; w->maxx = w->next_maxx; w->next_maxx = tmp;
+	tmp = w->maxy; w->maxy = w->next_maxy; w->next_maxy = tmp;
+	tmp = w->minx; w->minx = w->next_minx; w->next_minx = tmp;
+	tmp = w->miny; w->miny = w->next_miny; w->next_miny = tmp;
+}
+
+// Solve the spline coefficients of an envelope of the active lanes as
+// emd_spline_coefficients does, where the num[k] knots of lane k and its
+// coefficients start from k*w->max_extrema in x, y and c. The systems of
+// the lanes with at least four knots are interleaved to w->knot_x and
+// w->knot_y, and eliminated and solved in the same loops over the rows, in
+// which the rows beyond the system of a lane are computed but not used.
+// The elimination is fused with the forward sweep of the right hand side,
+// since row r+1 of the sweep only needs row r of the elimination.
+static libeemd_error_code _lockstep_solve_envelope(lockstep_workspace* w, double const* x_lanes,
+		double const* y_lanes, size_t const* num, double* c_lanes, bool const* active) {
+	const size_t max_extrema = w->max_extrema;
+	double* const x = w->knot_x;
+	double* const y = w->knot_y;
+	double* const c = w->knot_c;
+	double* const pivots = w->pivots;
+	double* const multipliers = w->multipliers;
+	// Number of intervals n of the system of each lane, or 0 if there is
+	// none
+	int64_t n[LANES];
+	int64_t n_max = 0;
+	for (size_t k=0; k<LANES; k++) {
+		n[k] = 0;
+		if (!active[k]) {
+			continue;
+		}
+		double const* const x_k = x_lanes + k*max_extrema;
+		double const* const y_k = y_lanes + k*max_extrema;
+		const size_t N = num[k];
+		if (N <= 1) {
+			return EMD_NOT_ENOUGH_POINTS_FOR_SPLINE;
+		}
+		// Fall back to linear interpolation (for N==2) or polynomial
+		// interpolation (for N==3)
+		if (N <= 3) {
+			int gsl_status = gsl_poly_dd_init(c_lanes + k*max_extrema, x_k, y_k, N);
+			if (gsl_status != GSL_SUCCESS) {
+				REprintf("Error reported by gsl_poly_dd_init: %s\n",
+					gsl_strerror(gsl_status));
+				return EMD_GSL_ERROR;
+			}
+			continue;
+		}
+		n[k] = (int64_t)N-1;
+		if (n[k] > n_max) {
+			n_max = n[k];
+		}
+		for (size_t i=0; i<N; i++) {
+			x[i*LANES+k] = x_k[i];
+			y[i*LANES+k] = y_k[i];
+		}
+	}
+	if (n_max == 0) {
+		return EMD_SUCCESS;
+	}
+	// Widths of the intervals at the ends of each system
+	double h_nm1[LANES];
+	double h_nm2[LANES];
+	for (size_t k=0; k<LANES; k++) {
+		const int64_t m = (n[k] >= 3)? n[k] : 3;
+		h_nm1[k] = x[m*LANES+k] - x[(m-1)*LANES+k];
+		h_nm2[k] = x[(m-1)*LANES+k] - x[(m-2)*LANES+k];
+	}
+	bool singular = false;
+	#pragma omp simd reduction(|:singular)
+	for (size_t k=0; k<LANES; k++) {
+		const double h_0 = x[1*LANES+k] - x[k];
+		const double h_1 = x[2*LANES+k] - x[1*LANES+k];
+		pivots[k] = h_0 + 2*h_1;
+		singular |= (n[k] != 0 && pivots[k] == 0);
+		c[1*LANES+k] = 3.0/(h_0 + h_1)*((y[2*LANES+k]-y[1*LANES+k])
+				- (h_1/h_0)*(y[1*LANES+k]-y[k]));
+	}
+	for (int64_t r=1; r<=n_max-2; r++) {
+		// Row r corresponds to knot i=r+1
+		const int64_t i = r+1;
+		double const* const x_im1 = x + (i-1)*LANES;
+		double const* const x_i = x + i*LANES;
+		double const* const x_ip1 = x + (i+1)*LANES;
+		double const* const y_im1 = y + (i-1)*LANES;
+		double const* const y_i = y + i*LANES;
+		double const* const y_ip1 = y + (i+1)*LANES;
+		double const* const pivots_above = pivots + (r-1)*LANES;
+		double* const pivots_r = pivots + r*LANES;
+		double* const multipliers_r = multipliers + r*LANES;
+		double const* const c_r = c + r*LANES;
+		double* const c_i = c + i*LANES;
+		#pragma omp simd reduction(|:singular)
+		for (size_t k=0; k<LANES; k++) {
+			const bool live = (r+2 <= n[k]);
+			const bool last = (r+2 == n[k]);
+			const double h_0 = x[1*LANES+k] - x[k];
+			const double h_1 = x[2*LANES+k] - x[1*LANES+k];
+			const double h_i = x_ip1[k] - x_i[k];
+			const double h_im1 = x_i[k] - x_im1[k];
+			const double supdiag_above = (r == 1)? h_1 - h_0 : x_i[k] - x_im1[k];
+			const double subdiag = last? h_nm2[k] - h_nm1[k] : h_im1;
+			const double diag = last? 2*h_nm2[k] + h_nm1[k] : 2*(h_im1 + h_i);
+			const double t = subdiag/pivots_above[k];
+			multipliers_r[k] = t;
+			pivots_r[k] = diag - t*supdiag_above;
+			singular |= (live && pivots_r[k] == 0);
+			// Forward sweep of row i, which is the last row n-1 of the
+			// system if row r of the elimination is its last row
+			const double g = 3.0*((y_ip1[k]-y_i[k])/h_i - (y_i[k]-y_im1[k])/h_im1);
+			const double g_last = 3.0/(h_nm1[k] + h_nm2[k])*((h_nm2[k]/h_nm1[k])*(y_ip1[k]-y_i[k])
+					- (y_i[k]-y_im1[k])) - t*c_r[k];
+			c_i[k] = last? g_last/pivots_r[k] : g - t*c_r[k];
+		}
+	}
+	if (singular) {
+		return EMD_INVALID_SPLINE_POINTS;
+	}
+	// Back substitution to get c_1 ... c_{n-2}
+	for (int64_t i=n_max-2; i>=1; i--) {
+		double const* const x_i = x + i*LANES;
+		double const* const x_ip1 = x + (i+1)*LANES;
+		double const* const pivots_above = pivots + (i-1)*LANES;
+		double* const c_i = c + i*LANES;
+		double const* const c_ip1 = c + (i+1)*LANES;
+		#pragma omp simd
+		for (size_t k=0; k<LANES; k++) {
+			const double supdiag = (i == 1)? (x[2*LANES+k]-x[1*LANES+k]) - (x[1*LANES+k]-x[k])
+				: x_ip1[k] - x_i[k];
+			const double value = (c_i[k] - supdiag*c_ip1[k])/pivots_above[k];
+			c_i[k] = (i+2 <= n[k])? value : c_i[k];
+		}
+	}
+	// End conditions
+	for (size_t k=0; k<LANES; k++) {
+		if (n[k] == 0) {
+			continue;
+		}
+		const int64_t m = n[k];
+		c[k] = c[1*LANES+k] + ((x[1*LANES+k]-x[k])/(x[2*LANES+k]-x[1*LANES+k]))
+			*(c[1*LANES+k]-c[2*LANES+k]);
+		c[m*LANES+k] = c[(m-1)*LANES+k] + ((x[m*LANES+k]-x[(m-1)*LANES+k])
+				/(x[(m-1)*LANES+k]-x[(m-2)*LANES+k]))*(c[(m-1)*LANES+k]-c[(m-2)*LANES+k]);
+		double* const c_k = c_lanes + k*max_extrema;
+		for (int64_t i=0; i<=m; i++) {
+			c_k[i] = c[i*LANES+k];
+		}
+	}
+	return EMD_SUCCESS;
+}
+
+libeemd_error_code lockstep_upper_envelopes(lockstep_workspace* __restrict w, size_t num_lanes,
+		libeemd_interpolation interpolation, spline_cursor* upper) {
+	// The minima are found as well, but not used
+	bool all_extrema_good[LANES];
+	_lockstep_find_extrema(w, all_extrema_good);
+	_lockstep_swap_extrema(w);
+	bool active[LANES];
+	size_t num_max[LANES];
+	for (size_t k=0; k<LANES; k++) {
+		active[k] = (k < num_lanes);
+		num_max[k] = w->next_num_max[k];
+	}
+	libeemd_error_code errcode = EMD_SUCCESS;
+	if (interpolation == EMD_INTERP_SPLINE) {
+		errcode = _lockstep_solve_envelope(w, w->maxx, w->maxy, num_max, w->max_c, active);
+	}
+	else {
+		// The other interpolants only depend on the neighbouring points, so
+		// there is no system to solve together
+		for (size_t k=0; k<num_lanes && errcode == EMD_SUCCESS; k++) {
+			const size_t offset = k*w->max_extrema;
+			errcode = emd_interpolant_coefficients(interpolation, w->maxx+offset, w->maxy+offset,
+					num_max[k], w->max_c+offset);
+		}
+	}
+	if (errcode != EMD_SUCCESS) {
+		return errcode;
+	}
+	for (size_t k=0; k<num_lanes; k++) {
+		const size_t offset = k*w->max_extrema;
+		spline_cursor_begin(&upper[k], interpolation, w->maxx+offset, w->maxy+offset,
+				num_max[k], w->max_c+offset);
+	}
+	return EMD_SUCCESS;
+}
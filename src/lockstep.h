@@ -0,0 +1,78 @@
+/*
+ ** Lock-step extrema and envelopes of several signals for Rlibeemd:
+ ** The signals of up to EMD_LOCKSTEP_LANES lanes are interleaved, so that
+ ** value i of lane k is stored at index i*EMD_LOCKSTEP_LANES+k. The slopes
+ ** of all lanes are compared and the spline systems of their envelopes
+ ** solved in the same loops over the lanes, which the compiler turns into
+ ** SIMD instructions across the signals. BEMD uses these for the
+ ** projections of the signal to several directions. Each lane gets the same
+ ** extrema and envelope as the signal would get alone.
+ */
+
+#ifndef _EEMD_LOCKSTEP_H_
+#define _EEMD_LOCKSTEP_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "arena.h"
+#include "eemd.h"
+#include "spline.h"
+
+// Number of signals handled together, the number of doubles in the widest
+// SIMD vector enabled at compile time but at least four, so that the loops
+// over the lanes also overlap the latencies of scalar code
+#if defined(__AVX512F__)
+#define EMD_LOCKSTEP_LANES 8
+#else
+#define EMD_LOCKSTEP_LANES 4
+#endif
+
+typedef struct {
+	// Number of samples in each signal
+	size_t N;
+	// Room for extrema of each envelope of each lane
+	size_t max_extrema;
+	// The interleaved signals
+	double* x;
+	// Extrema of the last scan and those found by the scan in progress,
+	// swapped after each scan as in sifting_workspace. The extrema of lane k
+	// start from index k*max_extrema.
+	double* maxx;
+	double* maxy;
+	double* minx;
+	double* miny;
+	double* next_maxx;
+	double* next_maxy;
+	double* next_minx;
+	double* next_miny;
+	// Spline coefficients of the upper envelope of each lane, stored like
+	// the extrema
+	double* max_c;
+	// The knots and coefficients of the envelope being solved interleaved
+	// like the signals, and the elimination of its spline systems
+	double* knot_x;
+	double* knot_y;
+	double* knot_c;
+	double* pivots;
+	double* multipliers;
+	// Numbers of extrema of each lane found by the last scan
+	size_t next_num_max[EMD_LOCKSTEP_LANES];
+	size_t next_num_min[EMD_LOCKSTEP_LANES];
+	// Memory of the workspace, see arena.h
+	emd_arena arena;
+} lockstep_workspace;
+
+lockstep_workspace* allocate_lockstep_workspace(size_t N);
+void free_lockstep_workspace(lockstep_workspace* w);
+
+// Upper envelopes of the first num_lanes lanes of w->x for BEMD. The maxima
+// of each lane are those of emd_find_maxima, and they are found for all
+// lanes in the same pass. The interpolants given by interpolation are solved
+// to w->max_c, with the cubic splines of all lanes solved together, and
+// upper[k] is set to evaluate the envelope of lane k. The envelopes are the
+// same as those of emd_evaluate_interpolant.
+libeemd_error_code lockstep_upper_envelopes(lockstep_workspace* __restrict w, size_t num_lanes,
+		libeemd_interpolation interpolation, spline_cursor* upper);
+
+#endif // _EEMD_LOCKSTEP_H_
@@ -0,0 +1,256 @@
+/*
+ ** Cache of the noise modes of CEEMDAN for Rlibeemd, see noise_cache.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "noise_cache.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define EMD_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define EMD_HAVE_MMAP 0
+#endif
+
+// Header at the start of a cache file
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	// Written as NOISE_CACHE_BYTE_ORDER, so that files of machines with a
+	// different byte order are not used
+	uint32_t byte_order;
+	noise_cache_key key;
+	uint64_t ensemble_size;
+	uint64_t num_modes;
+} noise_cache_header;
+
+#define NOISE_CACHE_MAGIC "EEMDNOIS"
+#define NOISE_CACHE_VERSION 1
+#define NOISE_CACHE_BYTE_ORDER 0x01020304u
+// The modes start at a page boundary after the header
+#define NOISE_CACHE_DATA_OFFSET 4096
+
+noise_cache_key noise_cache_make_key(size_t N, unsigned long int rng_seed, libeemd_rng rng,
+		unsigned int S_number, unsigned int num_siftings, emd_stopping const* stopping,
+		libeemd_interpolation interpolation) {
+	noise_cache_key key;
+	memset(&key, 0x00, sizeof(noise_cache_key));
+	key.N = N;
+	key.rng_seed = rng_seed;
+	key.rng = (uint32_t)rng;
+	key.num_siftings = num_siftings;
+	key.interpolation = (uint32_t)interpolation;
+	const libeemd_stopping criterion = (stopping != NULL)? stopping->criterion : EMD_STOP_S_NUMBER;
+	key.criterion = (uint32_t)criterion;
+	switch (criterion) {
+		case EMD_STOP_S_NUMBER:
+			key.S_number = S_number;
+			break;
+		case EMD_STOP_SD:
+			key.sd_limit = stopping->sd_limit;
+			break;
+		case EMD_STOP_RILLING:
+			key.theta_1 = stopping->theta_1;
+			key.theta_2 = stopping->theta_2;
+			key.alpha = stopping->alpha;
+			break;
+	}
+	return key;
+}
+
+noise_cache noise_cache_init(void) {
+	noise_cache c = {NULL, 0, 0, 0, NULL, 0, NULL, NULL};
+	return c;
+}
+
+#if EMD_HAVE_MMAP
+
+// Size of a file with the given numbers of members and modes, or zero if it
+// does not fit in size_t
+static size_t _noise_cache_size(size_t N, size_t ensemble_size, size_t num_modes) {
+	const size_t max_doubles = (SIZE_MAX-NOISE_CACHE_DATA_OFFSET)/sizeof(double);
+	if (ensemble_size != 0 && N > max_doubles/ensemble_size) {
+		return 0;
+	}
+	if (num_modes != 0 && N*ensemble_size > max_doubles/num_modes) {
+		return 0;
+	}
+	return NOISE_CACHE_DATA_OFFSET + num_modes*ensemble_size*N*sizeof(double);
+}
+
+// Path of the file of key in directory, named after the 64-bit FNV-1a hash
+// of the key. Different keys with the same hash are told apart by the key
+// in the header.
+static char* _noise_cache_path(char const* directory, noise_cache_key const* key) {
+	unsigned char const* bytes = (unsigned char const*)key;
+	uint64_t hash = 0xcbf29ce484222325u;
+	for (size_t i=0; i<sizeof(noise_cache_key); i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3u;
+	}
+	const size_t path_size = strlen(directory) + 64;
+	char* path = malloc(path_size);
+	snprintf(path, path_size, "%s/ceemdan-noise-%016llx.bin", directory, (unsigned long long)hash);
+	return path;
+}
+
+bool noise_cache_open(noise_cache* c, char const* directory, noise_cache_key const* key,
+		size_t ensemble_size, size_t num_modes) {
+	char* path = _noise_cache_path(directory, key);
+	const int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		free(path);
+		return false;
+	}
+	struct stat st;
+	void* mapping = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size >= NOISE_CACHE_DATA_OFFSET) {
+		mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		free(path);
+		return false;
+	}
+	const size_t mapping_size = (size_t)st.st_size;
+	noise_cache_header header;
+	memcpy(&header, mapping, sizeof(noise_cache_header));
+	const bool valid = memcmp(header.magic, NOISE_CACHE_MAGIC, sizeof(header.magic)) == 0
+		&& header.version == NOISE_CACHE_VERSION
+		&& header.byte_order == NOISE_CACHE_BYTE_ORDER
+		&& memcmp(&header.key, key, sizeof(noise_cache_key)) == 0
+		&& header.ensemble_size >= ensemble_size && header.num_modes >= num_modes
+		&& header.ensemble_size <= SIZE_MAX && header.num_modes <= SIZE_MAX
+		&& _noise_cache_size((size_t)key->N, (size_t)header.ensemble_size,
+				(size_t)header.num_modes) == mapping_size;
+	if (!valid) {
+		munmap(mapping, mapping_size);
+		free(path);
+		return false;
+	}
+	c->modes = (double*)((char*)mapping + NOISE_CACHE_DATA_OFFSET);
+	c->N = (size_t)key->N;
+	c->ensemble_size = (size_t)header.ensemble_size;
+	c->num_modes = (size_t)header.num_modes;
+	c->mapping = mapping;
+	c->mapping_size = mapping_size;
+	c->path = path;
+	c->temp_path = NULL;
+	return true;
+}
+
+bool noise_cache_create(noise_cache* c, char const* directory, noise_cache_key const* key,
+		size_t ensemble_size, size_t num_modes) {
+	const size_t mapping_size = _noise_cache_size((size_t)key->N, ensemble_size, num_modes);
+	if (mapping_size == 0) {
+		return false;
+	}
+	char* path = _noise_cache_path(directory, key);
+	const size_t temp_path_size = strlen(path) + 8;
+	char* temp_path = malloc(temp_path_size);
+	snprintf(temp_path, temp_path_size, "%s.XXXXXX", path);
+	const int fd = mkstemp(temp_path);
+	if (fd < 0) {
+		free(temp_path);
+		free(path);
+		return false;
+	}
+	// The noise is no secret, and other users may share the cache
+	fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	#ifdef __linux__
+	// Reserve the blocks, so that a full disk is noticed here and not as a
+	// fault while writing the mapping
+	const bool resized = (posix_fallocate(fd, 0, (off_t)mapping_size) == 0);
+	#else
+	const bool resized = (ftruncate(fd, (off_t)mapping_size) == 0);
+	#endif
+	void* mapping = resized? mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		unlink(temp_path);
+		free(temp_path);
+		free(path);
+		return false;
+	}
+	noise_cache_header header;
+	memset(&header, 0x00, sizeof(noise_cache_header));
+	memcpy(header.magic, NOISE_CACHE_MAGIC, sizeof(header.magic));
+	header.version = NOISE_CACHE_VERSION;
+	header.byte_order = NOISE_CACHE_BYTE_ORDER;
+	header.key = *key;
+	header.ensemble_size = ensemble_size;
+	header.num_modes = num_modes;
+	memcpy(mapping, &header, sizeof(noise_cache_header));
+	c->modes = (double*)((char*)mapping + NOISE_CACHE_DATA_OFFSET);
+	c->N = (size_t)key->N;
+	c->ensemble_size = ensemble_size;
+	c->num_modes = num_modes;
+	c->mapping = mapping;
+	c->mapping_size = mapping_size;
+	c->path = path;
+	c->temp_path = temp_path;
+	return true;
+}
+
+void noise_cache_commit(noise_cache* c) {
+	if (c->temp_path == NULL) {
+		return;
+	}
+	// Renaming replaces a file written by another process in the meantime,
+	// which holds the same modes. If it fails, the temporary file is removed
+	// when the cache is closed.
+	if (rename(c->temp_path, c->path) == 0) {
+		free(c->temp_path);
+		c->temp_path = NULL;
+	}
+}
+
+void noise_cache_close(noise_cache* c) {
+	if (c->mapping != NULL) {
+		munmap(c->mapping, c->mapping_size);
+	}
+	if (c->temp_path != NULL) {
+		unlink(c->temp_path);
+	}
+	free(c->temp_path);
+	free(c->path);
+	*c = noise_cache_init();
+}
+
+#else
+
+bool noise_cache_open(noise_cache* c, char const* directory, noise_cache_key const* key,
+		size_t ensemble_size, size_t num_modes) {
+	(void)c;
+	(void)directory;
+	(void)key;
+	(void)ensemble_size;
+	(void)num_modes;
+	return false;
+}
+
+bool noise_cache_create(noise_cache* c, char const* directory, noise_cache_key const* key,
+		size_t ensemble_size, size_t num_modes) {
+	(void)c;
+	(void)directory;
+	(void)key;
+	(void)ensemble_size;
+	(void)num_modes;
+	return false;
+}
+
+void noise_cache_commit(noise_cache* c) {
+	(void)c;
+}
+
+void noise_cache_close(noise_cache* c) {
+	*c = noise_cache_init();
+}
+
+#endif // EMD_HAVE_MMAP
@@ -0,0 +1,90 @@
+/*
+ ** Cache of the noise modes of CEEMDAN for Rlibeemd:
+ ** The noises added by CEEMDAN and their EMD modes depend only on the length
+ ** of the signal, the random number generator and its seed and the
+ ** parameters of the sifting, not on the signal itself. The cache keeps
+ ** them in a binary file named after a hash of these parameters, which is
+ ** memory-mapped so that several processes decomposing signals of the same
+ ** length can share it. The file holds a header followed by the modes as
+ ** doubles, laid out as [mode][member][N], where mode 0 is the white noise
+ ** itself. A new file is written under a temporary name and renamed when it
+ ** is complete, so other processes never see a partial file. Memory-mapped
+ ** files are only used on POSIX systems; elsewhere the cache is never hit
+ ** and never written.
+ */
+
+#ifndef _EEMD_NOISE_CACHE_H_
+#define _EEMD_NOISE_CACHE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "eemd.h"
+
+// Parameters that determine the noise modes. All fields are fixed-size and
+// without padding, so that the key can be hashed and compared bytewise.
+typedef struct {
+	uint64_t N;
+	uint64_t rng_seed;
+	uint32_t rng;
+	uint32_t S_number;
+	uint32_t num_siftings;
+	uint32_t interpolation;
+	uint32_t criterion;
+	uint32_t reserved;
+	double sd_limit;
+	double theta_1;
+	double theta_2;
+	double alpha;
+} noise_cache_key;
+
+typedef struct {
+	// Mapped modes, or NULL if the cache is not open
+	double* modes;
+	size_t N;
+	size_t ensemble_size;
+	size_t num_modes;
+	// The whole mapping of the file
+	void* mapping;
+	size_t mapping_size;
+	// Path of the file, and of the temporary file while it is being written
+	char* path;
+	char* temp_path;
+} noise_cache;
+
+// Key for the given parameters. Thresholds of unused stopping criteria are
+// left out, so they do not affect the key.
+noise_cache_key noise_cache_make_key(size_t N, unsigned long int rng_seed, libeemd_rng rng,
+		unsigned int S_number, unsigned int num_siftings, emd_stopping const* stopping,
+		libeemd_interpolation interpolation);
+
+// A closed cache
+noise_cache noise_cache_init(void);
+
+// Map the file of key in directory if it has the noise modes of at least
+// ensemble_size members and num_modes modes. Returns false if there is no
+// such file or it cannot be read.
+bool noise_cache_open(noise_cache* c, char const* directory, noise_cache_key const* key,
+		size_t ensemble_size, size_t num_modes);
+
+// Map a new temporary file in directory for ensemble_size members and
+// num_modes modes, whose modes are then written by the caller. Returns
+// false if the file cannot be created.
+bool noise_cache_create(noise_cache* c, char const* directory, noise_cache_key const* key,
+		size_t ensemble_size, size_t num_modes);
+
+// Make a file created by noise_cache_create visible to others under its
+// final name. The modes stay mapped.
+void noise_cache_commit(noise_cache* c);
+
+// Unmap the file. A temporary file that was not committed is removed.
+void noise_cache_close(noise_cache* c);
+
+// Mode mode_i of the noise of ensemble member en_i. The same mode of
+// consecutive members is contiguous.
+static inline double* noise_cache_mode(noise_cache const* c, size_t en_i, size_t mode_i) {
+	return c->modes + (mode_i*c->ensemble_size + en_i)*c->N;
+}
+
+#endif // _EEMD_NOISE_CACHE_H_
@@ -0,0 +1,90 @@
+/*
+ ** NUMA-aware thread placement for Rlibeemd, see numa.h
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <sched.h>
+#endif
+
+#include "numa.h"
+
+#if defined(_OPENMP) && _OPENMP >= 201511
+#define EMD_HAVE_PLACES 1
+#else
+#define EMD_HAVE_PLACES 0
+#endif
+
+size_t numa_num_domains(void) {
+	#if EMD_HAVE_PLACES
+	const int num_places = omp_get_num_places();
+	return (num_places > 0)? (size_t)num_places : 1;
+	#else
+	return 1;
+	#endif
+}
+
+size_t numa_thread_domain(size_t thread_id, size_t num_threads, size_t num_domains) {
+	if (num_domains <= 1 || num_threads == 0) {
+		return 0;
+	}
+	#if EMD_HAVE_PLACES
+	// Threads already bound by the OpenMP runtime stay in their place
+	const int place = omp_get_place_num();
+	if (place >= 0) {
+		return (size_t)place % num_domains;
+	}
+	#endif
+	// Otherwise consecutive threads share a domain, as with proc_bind(spread)
+	return thread_id*num_domains/num_threads;
+}
+
+#if EMD_HAVE_PLACES && defined(__linux__)
+struct numa_binding {
+	cpu_set_t saved;
+};
+
+numa_binding* pin_thread(size_t domain) {
+	if ((int)domain >= omp_get_num_places()) {
+		return NULL;
+	}
+	const int num_procs = omp_get_place_num_procs((int)domain);
+	if (num_procs <= 0) {
+		return NULL;
+	}
+	int* const procs = malloc((size_t)num_procs*sizeof(int));
+	omp_get_place_proc_ids((int)domain, procs);
+	cpu_set_t mask;
+	CPU_ZERO(&mask);
+	for (int i=0; i<num_procs; i++) {
+		if (procs[i] >= 0 && procs[i] < CPU_SETSIZE) {
+			CPU_SET(procs[i], &mask);
+		}
+	}
+	free(procs);
+	numa_binding* binding = malloc(sizeof(numa_binding));
+	if (sched_getaffinity(0, sizeof(cpu_set_t), &binding->saved) != 0 ||
+			sched_setaffinity(0, sizeof(cpu_set_t), &mask) != 0) {
+		free(binding);
+		return NULL;
+	}
+	return binding;
+}
+
+void unpin_thread(numa_binding* binding) {
+	if (binding == NULL) {
+		return;
+	}
+	sched_setaffinity(0, sizeof(cpu_set_t), &binding->saved);
+	free(binding);
+}
+#else
+numa_binding* pin_thread(size_t domain) {
+	(void)domain;
+	return NULL;
+}
+
+void unpin_thread(numa_binding* binding) {
+	(void)binding;
+}
+#endif
@@ -0,0 +1,36 @@
+/*
+ ** NUMA-aware thread placement for Rlibeemd:
+ ** The NUMA domains are the OpenMP places given by OMP_PLACES, e.g.
+ ** OMP_PLACES=sockets. Each thread of a team is assigned to a domain, either
+ ** the place it is bound to by OMP_PROC_BIND or by spreading the threads
+ ** evenly over the places, and it can optionally be pinned to the
+ ** processors of that domain for the duration of a parallel region. Without
+ ** places, or without OpenMP 4.5, there is a single domain and pinning does
+ ** nothing.
+ */
+
+#ifndef _EEMD_NUMA_H_
+#define _EEMD_NUMA_H_
+
+#include <stddef.h>
+#include <stdlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Saved processor affinity of a pinned thread
+typedef struct numa_binding numa_binding;
+
+// Number of NUMA domains, at least one
+size_t numa_num_domains(void);
+
+// Domain of the calling thread thread_id in a team of num_threads threads
+size_t numa_thread_domain(size_t thread_id, size_t num_threads, size_t num_domains);
+
+// Pin the calling thread to the processors of domain. Returns the previous
+// affinity to be restored with unpin_thread, or NULL if the thread was not
+// pinned.
+numa_binding* pin_thread(size_t domain);
+void unpin_thread(numa_binding* binding);
+
+#endif // _EEMD_NUMA_H_
@@ -0,0 +1,97 @@
+/*
+ ** Counter-based random number generation for Rlibeemd, see philox.h
+ */
+
+#include "philox.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Multipliers and key increments of Philox4x32
+#define PHILOX_M0 UINT32_C(0xD2511F53)
+#define PHILOX_M1 UINT32_C(0xCD9E8D57)
+#define PHILOX_W0 UINT32_C(0x9E3779B9)
+#define PHILOX_W1 UINT32_C(0xBB67AE85)
+
+// Number of sample pairs generated at a time. The uniform numbers of a block
+// are first stored to arrays on the stack and then transformed to normal
+// numbers with a separate loop, which the compiler can vectorize.
+#define PHILOX_BLOCK 64
+
+// Philox4x32 with 10 rounds. Computes four 32-bit random numbers from the
+// counter (ctr[0], ..., ctr[3]) and the key (k0, k1).
+static inline void philox4x32_10(uint32_t ctr[4], uint32_t k0, uint32_t k1) {
+	for (int round=0; round<10; round++) {
+		const uint64_t p0 = (uint64_t)PHILOX_M0*ctr[0];
+		const uint64_t p1 = (uint64_t)PHILOX_M1*ctr[2];
+		const uint32_t c1 = ctr[1];
+		const uint32_t c3 = ctr[3];
+		ctr[0] = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+		ctr[1] = (uint32_t)p1;
+		ctr[2] = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+		ctr[3] = (uint32_t)p0;
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+}
+
+// Compute the two uniform random numbers of sample pair 'pair'. The first is
+// in (0,1] and the second in [0,1), both with 53 random bits.
+static inline void philox_uniform_pair(uint64_t key, uint64_t stream, uint64_t pair,
+		double* u1, double* u2) {
+	uint32_t ctr[4] = { (uint32_t)pair, (uint32_t)(pair >> 32),
+		(uint32_t)stream, (uint32_t)(stream >> 32) };
+	philox4x32_10(ctr, (uint32_t)key, (uint32_t)(key >> 32));
+	const uint64_t a = ((uint64_t)ctr[0] << 32) | ctr[1];
+	const uint64_t b = ((uint64_t)ctr[2] << 32) | ctr[3];
+	const double two_pow_minus_53 = 1.0/9007199254740992.0;
+	*u1 = (double)((a >> 11) + 1)*two_pow_minus_53;
+	*u2 = (double)(b >> 11)*two_pow_minus_53;
+}
+
+// A single sample pair with the Box-Muller transform
+static void philox_gaussian_pair(uint64_t key, uint64_t stream, uint64_t pair,
+		double sigma, double z[2]) {
+	double u1, u2;
+	philox_uniform_pair(key, stream, pair, &u1, &u2);
+	const double r = sigma*sqrt(-2.0*log(u1));
+	z[0] = r*cos(2.0*M_PI*u2);
+	z[1] = r*sin(2.0*M_PI*u2);
+}
+
+void philox_gaussian(uint64_t key, uint64_t stream, size_t first, size_t n,
+		double sigma, double* __restrict output) {
+	size_t i = 0;
+	// Samples 2*p and 2*p+1 come from the same pair p. If the first sample
+	// is the second of its pair, it is computed separately.
+	if (n > 0 && first % 2 == 1) {
+		double z[2];
+		philox_gaussian_pair(key, stream, first/2, sigma, z);
+		output[0] = z[1];
+		i = 1;
+	}
+	double u1[PHILOX_BLOCK];
+	double u2[PHILOX_BLOCK];
+	while (n-i >= 2) {
+		const size_t num_pairs = ((n-i)/2 < PHILOX_BLOCK)? (n-i)/2 : PHILOX_BLOCK;
+		const uint64_t first_pair = (first+i)/2;
+		for (size_t k=0; k<num_pairs; k++) {
+			philox_uniform_pair(key, stream, first_pair+k, &u1[k], &u2[k]);
+		}
+		double* const out = output+i;
+		#pragma omp simd
+		for (size_t k=0; k<num_pairs; k++) {
+			const double r = sigma*sqrt(-2.0*log(u1[k]));
+			out[2*k] = r*cos(2.0*M_PI*u2[k]);
+			out[2*k+1] = r*sin(2.0*M_PI*u2[k]);
+		}
+		i += 2*num_pairs;
+	}
+	// The last sample is the first of its pair
+	if (i < n) {
+		double z[2];
+		philox_gaussian_pair(key, stream, (first+i)/2, sigma, z);
+		output[i] = z[0];
+	}
+}
@@ -0,0 +1,28 @@
+/*
+ ** Counter-based random number generation for Rlibeemd:
+ ** The Philox4x32-10 generator of
+ **   J. K. Salmon, M. A. Moraes, R. O. Dror and D. E. Shaw,
+ **   Parallel random numbers: as easy as 1, 2, 3,
+ **   Proc. Int. Conf. for High Performance Computing, Networking, Storage
+ **   and Analysis (SC11), 2011.
+ ** The generator has no sequential state: each output is a function of a
+ ** key and a counter only, so any part of any noise realization can be
+ ** computed directly.
+ */
+
+#ifndef _EEMD_PHILOX_H_
+#define _EEMD_PHILOX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+
+// Write n normally distributed random numbers with zero mean and standard
+// deviation sigma to output. The numbers are the samples first, first+1,
+// ..., first+n-1 of the realization identified by key and stream, so that
+// e.g. key is the RNG seed and stream is the index of the ensemble member.
+// The result does not depend on how a realization is split into calls.
+void philox_gaussian(uint64_t key, uint64_t stream, size_t first, size_t n,
+		double sigma, double* __restrict output);
+
+#endif // _EEMD_PHILOX_H_
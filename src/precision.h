@@ -0,0 +1,21 @@
+/*
+ ** Precision-generic code for Rlibeemd:
+ ** The sifting pipeline (extrema, spline envelopes, _sift and _emd) and its
+ ** workspaces are written once in the *_impl.h and workspace_template.h
+ ** files, which are included twice: once with EMD_REAL defined as double and
+ ** EMD_SUFFIX empty, and once with EMD_REAL defined as float and EMD_SUFFIX
+ ** defined as _f. The double versions keep their original names, and the
+ ** float versions get the suffix _f. The extrema and the spline
+ ** coefficients are always computed in double, since there are few of them
+ ** compared to the signal.
+ */
+
+#ifndef _EEMD_PRECISION_H_
+#define _EEMD_PRECISION_H_
+
+#define EMD_CONCAT_(a, b) a##b
+#define EMD_CONCAT(a, b) EMD_CONCAT_(a, b)
+// Name of a precision-generic function or type in the current instantiation
+#define EMD_NAME(name) EMD_CONCAT(name, EMD_SUFFIX)
+
+#endif // _EEMD_PRECISION_H_
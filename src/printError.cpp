@@ -27,6 +27,20 @@ switch (err) {
 			stop("Error reported by GSL library");
     case EMD_NO_CONVERGENCE_IN_SIFTING :
       stop("Convergence not reached after sifting 10000 times");
+    case EMD_INVALID_NUM_IMFS :
+      stop("Invalid number of IMFs (zero)");
+    case EMD_INVALID_RNG :
+      stop("Unknown random number generator");
+    case EMD_INVALID_PRECISION :
+      stop("Unknown floating point precision");
+    case EMD_INVALID_AFFINITY :
+      stop("Unknown thread affinity");
+    case EMD_INVALID_STOPPING :
+      stop("Unknown stopping criterion or invalid thresholds");
+    case EMD_INVALID_INTERPOLATION :
+      stop("Unknown interpolation of the envelopes");
+    case EMD_INVALID_NOISE_CACHE :
+      stop("The directory of the noise cache does not exist");
 		default :
 			stop("Error code with unknown meaning. Please file a bug!");
 	}
@@ -18,11 +18,225 @@
 
 #include "spline.h"
 
-libeemd_error_code emd_evaluate_spline(double const* __restrict x, double const* __restrict y,
-		size_t N, double* __restrict spline_y, double* __restrict spline_workspace) {
-	gsl_set_error_handler_off();
+#define EMD_REAL double
+#define EMD_SUFFIX
+#include "spline_impl.h"
+#undef EMD_SUFFIX
+#undef EMD_REAL
+#define EMD_REAL float
+#define EMD_SUFFIX _f
+#include "spline_impl.h"
+#undef EMD_SUFFIX
+#undef EMD_REAL
+
+// Eliminate the (N-2)x(N-2) tridiagonal system of the not-a-knot spline
+// through the knots x, for N >= 4. The system is the one described in
+// emd_update_spline_coefficients below, and the elimination is done in the
+// same order as in gsl_linalg_solve_tridiag, so the results are identical.
+//
+// Row r of the system depends only on the knots r, r+1 and r+2, on whether
+// it is one of the first two rows or the last row, and on the pivot of the
+// row above it. So if system has been eliminated for previous_x and the
+// pivot of the row above is the same as that of the row with the same knot
+// in the previous system, a row with unchanged knots is the same as in the
+// previous system and it is just copied. Typically the knots only change
+// here and there between siftings, and after each change the recomputed
+// pivots reach the previous ones exactly within a few rows.
+static libeemd_error_code _eliminate_spline_system(double const* __restrict x, size_t N,
+		double const* __restrict previous_x, spline_system* __restrict system) {
 	const size_t n = N-1;
-	const size_t max_j = (size_t)x[n];
+	const size_t previous_N = (previous_x != NULL)? system->N : 0;
+	const bool reuse = (previous_N >= 4);
+	// The previous elimination is kept until the new one is done
+	double* const pivots = reuse? system->next_pivots : system->pivots;
+	double* const multipliers = reuse? system->next_multipliers : system->multipliers;
+	double const* const previous_pivots = system->pivots;
+	double const* const previous_multipliers = system->multipliers;
+	// Mark the system as not eliminated until all rows are done
+	system->N = 0;
+	const double h_0 = x[1]-x[0];
+	const double h_1 = x[2]-x[1];
+	const double h_nm1 = x[n]-x[n-1];
+	const double h_nm2 = x[n-1]-x[n-2];
+	pivots[0] = h_0 + 2*h_1;
+	if (pivots[0] == 0) {
+		return EMD_INVALID_SPLINE_POINTS;
+	}
+	// Row of the previous system whose pivot equals the pivot of the
+	// previous row, or 0 if there is none
+	size_t match = 0;
+	// Position in previous_x for finding the knot of the current row
+	size_t j = 0;
+	for (size_t r=1; r<=n-2; r++) {
+		if (match != 0) {
+			const size_t previous_r = match+1;
+			if (previous_r <= previous_N-3 && (r == n-2) == (previous_r == previous_N-3)
+					&& previous_x[previous_r] == x[r] && previous_x[previous_r+1] == x[r+1]
+					&& previous_x[previous_r+2] == x[r+2]) {
+				pivots[r] = previous_pivots[previous_r];
+				multipliers[r] = previous_multipliers[previous_r];
+				match = previous_r;
+				continue;
+			}
+		}
+		// Row r corresponds to knot i=r+1. Its subdiagonal element and the
+		// superdiagonal element of the row above are needed.
+		const size_t i = r+1;
+		const double supdiag_above = (r == 1)? h_1 - h_0 : x[i] - x[i-1];
+		double subdiag;
+		double diag;
+		if (r < n-2) {
+			const double h_i = x[i+1] - x[i];
+			const double h_im1 = x[i] - x[i-1];
+			subdiag = h_im1;
+			diag = 2*(h_im1 + h_i);
+		}
+		else {
+			subdiag = h_nm2 - h_nm1;
+			diag = 2*h_nm2 + h_nm1;
+		}
+		const double t = subdiag/pivots[r-1];
+		multipliers[r] = t;
+		pivots[r] = diag - t*supdiag_above;
+		if (pivots[r] == 0) {
+			return EMD_INVALID_SPLINE_POINTS;
+		}
+		// Check if the elimination has reached the previous one
+		match = 0;
+		if (reuse) {
+			while (j < previous_N && previous_x[j] < x[r]) {
+				j++;
+			}
+			if (j >= 1 && j <= previous_N-3 && previous_x[j] == x[r]
+					&& previous_pivots[j] == pivots[r]) {
+				match = j;
+			}
+		}
+	}
+	if (reuse) {
+		system->next_pivots = system->pivots;
+		system->next_multipliers = system->multipliers;
+		system->pivots = pivots;
+		system->multipliers = multipliers;
+	}
+	system->N = N;
+	return EMD_SUCCESS;
+}
+
+// Right hand side of the spline system through (x, y) with n = N-1 >= 3
+// intervals, solved with the elimination in pivots and multipliers to c
+typedef struct {
+	double const* x;
+	double const* y;
+	size_t n;
+	double const* pivots;
+	double const* multipliers;
+	double* c;
+} spline_rhs;
+
+// Apply the elimination to the first row of the right hand side
+static inline void _forward_first(spline_rhs const* s) {
+	double const* const x = s->x;
+	double const* const y = s->y;
+	const double h_0 = x[1]-x[0];
+	const double h_1 = x[2]-x[1];
+	s->c[1] = 3.0/(h_0 + h_1)*((y[2]-y[1]) - (h_1/h_0)*(y[1]-y[0]));
+}
+
+// Apply the elimination to row i of the right hand side, for 2 <= i <= n-2
+static inline void _forward_row(spline_rhs const* s, size_t i) {
+	double const* const x = s->x;
+	double const* const y = s->y;
+	const double h_i = x[i+1] - x[i];
+	const double h_im1 = x[i] - x[i-1];
+	const double g = 3.0*((y[i+1]-y[i])/h_i - (y[i]-y[i-1])/h_im1);
+	s->c[i] = g - s->multipliers[i-1]*s->c[i-1];
+}
+
+// Apply the elimination to the last row of the right hand side, and start
+// the back substitution from it
+static inline void _forward_last(spline_rhs const* s) {
+	double const* const x = s->x;
+	double const* const y = s->y;
+	double* const c = s->c;
+	const size_t n = s->n;
+	const double h_nm1 = x[n]-x[n-1];
+	const double h_nm2 = x[n-1]-x[n-2];
+	c[n-1] = 3.0/(h_nm1 + h_nm2)*((h_nm2/h_nm1)*(y[n]-y[n-1]) - (y[n-1]-y[n-2]))
+		- s->multipliers[n-2]*c[n-2];
+	c[n-1] = c[n-1]/s->pivots[n-2];
+}
+
+// Back substitution of row i, for 1 <= i <= n-2
+static inline void _backward_row(spline_rhs const* s, size_t i) {
+	double const* const x = s->x;
+	double* const c = s->c;
+	const double supdiag = (i == 1)? (x[2]-x[1]) - (x[1]-x[0]) : x[i+1] - x[i];
+	c[i] = (c[i] - supdiag*c[i+1])/s->pivots[i-1];
+}
+
+// Compute the coefficients at the end points from the not-a-knot conditions
+static inline void _end_conditions(spline_rhs const* s) {
+	double const* const x = s->x;
+	double* const c = s->c;
+	const size_t n = s->n;
+	c[0] = c[1] + ((x[1]-x[0])/(x[2]-x[1]))*(c[1]-c[2]);
+	c[n] = c[n-1] + ((x[n]-x[n-1])/(x[n-1]-x[n-2]))*(c[n-1]-c[n-2]);
+}
+
+// Solve the right hand sides of one or two spline systems, with b NULL for
+// one. Each step of the forward sweep and of the back substitution depends
+// on the previous one, so the rows of the two systems are interleaved in
+// the same loops to overlap their latencies. Each system is solved with the
+// same operations as if it were alone.
+static void _solve_spline_rhs(spline_rhs const* a, spline_rhs const* b) {
+	const size_t n_a = a->n;
+	const size_t n_b = (b != NULL)? b->n : 0;
+	_forward_first(a);
+	if (b != NULL) {
+		_forward_first(b);
+	}
+	size_t i = 2;
+	for (; i+2<=n_a && i+2<=n_b; i++) {
+		_forward_row(a, i);
+		_forward_row(b, i);
+	}
+	for (size_t j=i; j+2<=n_a; j++) {
+		_forward_row(a, j);
+	}
+	for (size_t j=i; j+2<=n_b; j++) {
+		_forward_row(b, j);
+	}
+	_forward_last(a);
+	if (b != NULL) {
+		_forward_last(b);
+	}
+	// Back substitution to get c_1 ... c_{n-2}, where k counts the rows
+	// from the bottom
+	size_t k = 2;
+	for (; k+1<=n_a && k+1<=n_b; k++) {
+		_backward_row(a, n_a-k);
+		_backward_row(b, n_b-k);
+	}
+	for (size_t l=k; l+1<=n_a; l++) {
+		_backward_row(a, n_a-l);
+	}
+	for (size_t l=k; l+1<=n_b; l++) {
+		_backward_row(b, n_b-l);
+	}
+	_end_conditions(a);
+	if (b != NULL) {
+		_end_conditions(b);
+	}
+}
+
+// Solve the coefficients for N <= 3 points, or eliminate the system for
+// N >= 4 if its knots have changed, in which case rhs is set up for solving
+// the right hand side to coeffs. Returns in *solve whether that is needed.
+static libeemd_error_code _prepare_spline(double const* __restrict x, double const* __restrict y,
+		size_t N, double const* __restrict previous_x, spline_system* __restrict system,
+		double* __restrict coeffs, spline_rhs* rhs, bool* solve) {
+	*solve = false;
 	if (N <= 1) {
 		return EMD_NOT_ENOUGH_POINTS_FOR_SPLINE;
 	}
@@ -41,15 +255,13 @@ libeemd_error_code emd_evaluate_spline(double const* __restrict x, double const*
 	// Fall back to linear interpolation (for N==2) or polynomial interpolation
 	// (for N==3)
 	if (N <= 3) {
-		int gsl_status = gsl_poly_dd_init(spline_workspace, x, y, N);
+		system->N = 0;
+		int gsl_status = gsl_poly_dd_init(coeffs, x, y, N);
 		if (gsl_status != GSL_SUCCESS) {
 			REprintf("Error reported by gsl_poly_dd_init: %s\n",
 				gsl_strerror(gsl_status));
 			return EMD_GSL_ERROR;
 		}
-		for (size_t j=0; j<=max_j; j++) {
-		  spline_y[j] = gsl_poly_dd_eval(spline_workspace, x, N, (double)j);
-		}
 		return EMD_SUCCESS;
 	}
 	// For N >= 4, interpolate by using cubic splines with not-a-node end conditions.
@@ -59,80 +271,243 @@ libeemd_error_code emd_evaluate_spline(double const* __restrict x, double const*
 	// Extra homework assignment for anyone reading this: Implement this
 	// algorithm in GSL, so that next time someone needs these end conditions
 	// they can just use GSL.
-	const size_t sys_size = N-2;
-	double* const c = spline_workspace;
-	double* const diag = c+N;
-	double* const supdiag = diag + sys_size;
-	double* const subdiag = supdiag + (sys_size-1);
-	double* const g = subdiag + (sys_size-1);
-	// Define some constants for easier comparison with Engeln-Mullges & Uhlig
-	// and let the compiler optimize them away.
+	//
+	// The (N-2)x(N-2) linear system Ac=g has a tridiagonal matrix A, which
+	// only depends on the knots x. If they are the same as before, only the
+	// right hand side g needs to be solved. A zero pivot of a singular
+	// system is reported as EMD_INVALID_SPLINE_POINTS.
+	if (previous_x == NULL || system->N != N || memcmp(x, previous_x, N*sizeof(double)) != 0) {
+		libeemd_error_code err = _eliminate_spline_system(x, N, previous_x, system);
+		if (err != EMD_SUCCESS) {
+			return err;
+		}
+	}
+	rhs->x = x;
+	rhs->y = y;
+	rhs->n = N-1;
+	rhs->pivots = system->pivots;
+	rhs->multipliers = system->multipliers;
+	rhs->c = coeffs;
+	*solve = true;
+	return EMD_SUCCESS;
+}
+
+void spline_cursor_fill(spline_cursor* s, size_t j, size_t n, double* __restrict values) {
+	double const* const x = s->x;
+	const size_t end = j+n;
+	assert(n <= INT_MAX);
+	// Linear or polynomial interpolation for splines with N <= 3
+	if (s->form == SPLINE_FORM_POLYNOMIAL) {
+		for (; j<end; j++) {
+			*values++ = gsl_poly_dd_eval(s->c, x, s->N, (double)j);
+		}
+		return;
+	}
+	while (j < end) {
+		while (j > x[s->i+1]) {
+			s->i++;
+			assert(s->i < s->N-1);
+			spline_cursor_interval(s);
+		}
+		// Interval i extends to the last integer point not after x[i+1]
+		size_t interval_end = (size_t)x[s->i+1] + 1;
+		if (interval_end > end) {
+			interval_end = end;
+		}
+		const int count = (int)(interval_end-j);
+		// The differences dx are exact, since the points and knots are
+		// integers or half-integers
+		const double dx_0 = (double)j - x[s->i];
+		const double a_i = s->a_i;
+		const double b_i = s->b_i;
+		const double c_i = s->c_i;
+		const double d_i = s->d_i;
+		int k = 0;
+		if (dx_0 == 0) {
+			values[0] = s->y[s->i];
+			k = 1;
+		}
+		#pragma omp simd
+		for (int m=k; m<count; m++) {
+			const double dx = dx_0 + (double)m;
+			values[m] = a_i + dx*(b_i + dx*(c_i + dx*d_i));
+		}
+		values += count;
+		j = interval_end;
+	}
+}
+
+libeemd_error_code emd_spline_coefficients(double const* __restrict x, double const* __restrict y,
+		size_t N, double* __restrict coeffs) {
+	// For N >= 4 the elimination is stored after the coefficients
+	spline_system system = {0, coeffs+N, coeffs+2*N-2, NULL, NULL};
+	return emd_update_spline_coefficients(x, y, N, NULL, &system, coeffs);
+}
+
+// Sign of a, or 0 if a is zero
+static inline int _sign(double a) {
+	return (a > 0) - (a < 0);
+}
+
+// Slope at an end point of the PCHIP interpolant, given the widths h_0 and
+// h_1 and the slopes delta_0 and delta_1 of the first two intervals counted
+// from that end. The three-point estimate is limited so that the
+// interpolant stays monotone.
+static double _pchip_end_slope(double h_0, double h_1, double delta_0, double delta_1) {
+	const double m = ((2*h_0 + h_1)*delta_0 - h_0*delta_1)/(h_0 + h_1);
+	if (_sign(m) != _sign(delta_0)) {
+		return 0;
+	}
+	if (_sign(delta_0) != _sign(delta_1) && fabs(m) > fabs(3*delta_0)) {
+		return 3*delta_0;
+	}
+	return m;
+}
+
+// Slopes at the N >= 3 points of the monotone piecewise cubic Hermite
+// interpolant of F. N. Fritsch and R. E. Carlson, Monotone Piecewise Cubic
+// Interpolation, SIAM J. Numer. Anal. 17 (1980) 238-246, with the end
+// conditions of Matlab's pchip. The slope at an interior point is the
+// weighted harmonic mean of the slopes of its intervals, or zero at a local
+// extremum of the points.
+static void _pchip_slopes(double const* __restrict x, double const* __restrict y, size_t N,
+		double* __restrict m) {
+	double h_previous = x[1]-x[0];
+	double delta_previous = (y[1]-y[0])/h_previous;
+	for (size_t k=1; k+1<N; k++) {
+		const double h = x[k+1]-x[k];
+		const double delta = (y[k+1]-y[k])/h;
+		if (_sign(delta_previous)*_sign(delta) <= 0) {
+			m[k] = 0;
+		}
+		else {
+			const double w_1 = 2*h + h_previous;
+			const double w_2 = h + 2*h_previous;
+			m[k] = (w_1 + w_2)/(w_1/delta_previous + w_2/delta);
+		}
+		h_previous = h;
+		delta_previous = delta;
+	}
+	const size_t n = N-1;
 	const double h_0 = x[1]-x[0];
 	const double h_1 = x[2]-x[1];
 	const double h_nm1 = x[n]-x[n-1];
 	const double h_nm2 = x[n-1]-x[n-2];
-	// Describe the (N-2)x(N-2) linear system Ac=g with the tridiagonal
-	// matrix A defined by subdiag, diag and supdiag
-	// first row
-	diag[0] = h_0 + 2*h_1;
-	supdiag[0] = h_1 - h_0;
-	g[0] = 3.0/(h_0 + h_1)*((y[2]-y[1]) - (h_1/h_0)*(y[1]-y[0]));
-	// rows 2 to n-2
-	for (size_t i=2; i<=n-2; i++) {
-		const double h_i = x[i+1] - x[i];
-		const double h_im1 = x[i] - x[i-1];
-
-		subdiag[i-2] = h_im1;
-		diag[i-1] = 2*(h_im1 + h_i);
-		supdiag[i-1] = h_i;
-		g[i-1] = 3.0*((y[i+1]-y[i])/h_i - (y[i]-y[i-1])/h_im1);
-	}
-	// final row
-	subdiag[n-3] = h_nm2 - h_nm1;
-	diag[n-2] = 2*h_nm2 + h_nm1;
-	g[n-2] = 3.0/(h_nm1 + h_nm2)*((h_nm2/h_nm1)*(y[n]-y[n-1]) - (y[n-1]-y[n-2]));
-	// Solve to get c_1 ... c_{n-1}
-	gsl_vector_view diag_vec = gsl_vector_view_array(diag, n-1);
-	gsl_vector_view supdiag_vec = gsl_vector_view_array(supdiag, n-2);
-	gsl_vector_view subdiag_vec = gsl_vector_view_array(subdiag, n-2);
-	gsl_vector_view g_vec = gsl_vector_view_array(g, n-1);
-	gsl_vector_view solution_vec = gsl_vector_view_array(c+1, n-1);
-	int gsl_status = gsl_linalg_solve_tridiag(&diag_vec.vector,
-			                                    &supdiag_vec.vector,
-												&subdiag_vec.vector,
-												&g_vec.vector,
-												&solution_vec.vector);
-	if (gsl_status != GSL_SUCCESS) {
-	  REprintf("Error reported by gsl_linalg_solve_tridiag: %s\n",
-				gsl_strerror(gsl_status));
-		return EMD_GSL_ERROR;
-	}
-	// Compute c[0] and c[n]
-	c[0] = c[1] + (h_0/h_1)*(c[1]-c[2]);
-	c[n] = c[n-1] + (h_nm1/h_nm2)*(c[n-1]-c[n-2]);
-	// The coefficients b_i and d_i are computed from the c_i's, so just
-	// evaluate the spline at the required points. In this case it is easy to
-	// find the required interval for spline evaluation, since the evaluation
-	// points j just increase monotonically from 0 to max_j.
-	size_t i = 0;
-	for (size_t j=0; j<=max_j; j++) {
-		if (j > x[i+1]) {
-			i++;
-			assert(i < n);
-		}
-		const double dx = (double)j-x[i];
-		if (dx == 0) {
-			spline_y[j] = y[i];
-			continue;
-		}
-		// Compute coefficients b_i and d_i
-		const double h_i = x[i+1] - x[i];
-		const double a_i = y[i];
-		const double b_i = (y[i+1]-y[i])/h_i - (h_i/3.0)*(c[i+1]+2*c[i]);
-		const double c_i = c[i];
-		const double d_i = (c[i+1]-c[i])/(3.0*h_i);
-		// evaluate spline at x=j using the Horner scheme
-		spline_y[j] = a_i + dx*(b_i + dx*(c_i + dx*d_i));
+	m[0] = _pchip_end_slope(h_0, h_1, (y[1]-y[0])/h_0, (y[2]-y[1])/h_1);
+	m[n] = _pchip_end_slope(h_nm1, h_nm2, (y[n]-y[n-1])/h_nm1, (y[n-1]-y[n-2])/h_nm2);
+}
+
+// Slope at a point of the Akima interpolant, given the slopes of the two
+// intervals before and the two intervals after the point
+static inline double _akima_slope(double delta_m2, double delta_m1, double delta_0,
+		double delta_1) {
+	const double w_1 = fabs(delta_1 - delta_0);
+	const double w_2 = fabs(delta_m1 - delta_m2);
+	if (w_1 + w_2 == 0) {
+		return 0.5*(delta_m1 + delta_0);
+	}
+	return (w_1*delta_m1 + w_2*delta_0)/(w_1 + w_2);
+}
+
+// Slopes at the N >= 3 points of the interpolant of H. Akima, A New Method
+// of Interpolation and Smooth Curve Fitting Based on Local Procedures, J.
+// ACM 17 (1970) 589-602. The slopes of the intervals are extended by two
+// intervals at both ends by quadratic extrapolation as in the article. The
+// loop keeps the slopes of the four intervals around point k.
+static void _akima_slopes(double const* __restrict x, double const* __restrict y, size_t N,
+		double* __restrict m) {
+	const size_t n = N-1;
+	const double delta_first = (y[1]-y[0])/(x[1]-x[0]);
+	const double delta_second = (y[2]-y[1])/(x[2]-x[1]);
+	double delta_m2 = 3*delta_first - 2*delta_second;
+	double delta_m1 = 2*delta_first - delta_second;
+	double delta_0 = delta_first;
+	double delta_1 = delta_second;
+	for (size_t k=0; k<=n; k++) {
+		m[k] = _akima_slope(delta_m2, delta_m1, delta_0, delta_1);
+		delta_m2 = delta_m1;
+		delta_m1 = delta_0;
+		delta_0 = delta_1;
+		// Slope of interval k+2
+		if (k+2 < n) {
+			delta_1 = (y[k+3]-y[k+2])/(x[k+3]-x[k+2]);
+		}
+		else if (k+2 == n) {
+			delta_1 = 2*delta_0 - delta_m1;
+		}
+		else {
+			delta_1 = 3*delta_m1 - 2*delta_m2;
+		}
+	}
+}
+
+libeemd_error_code emd_interpolant_coefficients(libeemd_interpolation interpolation,
+		double const* __restrict x, double const* __restrict y, size_t N,
+		double* __restrict coeffs) {
+	if (interpolation == EMD_INTERP_SPLINE) {
+		return emd_spline_coefficients(x, y, N, coeffs);
+	}
+	if (N <= 1) {
+		return EMD_NOT_ENOUGH_POINTS_FOR_SPLINE;
+	}
+	// Two points are always interpolated linearly
+	if (N >= 3 && interpolation == EMD_INTERP_PCHIP) {
+		_pchip_slopes(x, y, N, coeffs);
+	}
+	else if (N >= 3 && interpolation == EMD_INTERP_AKIMA) {
+		_akima_slopes(x, y, N, coeffs);
+	}
+	return EMD_SUCCESS;
+}
+
+libeemd_error_code emd_update_spline_coefficients(double const* __restrict x, double const* __restrict y,
+		size_t N, double const* __restrict previous_x, spline_system* __restrict system,
+		double* __restrict coeffs) {
+	spline_rhs rhs;
+	bool solve;
+	libeemd_error_code err = _prepare_spline(x, y, N, previous_x, system, coeffs, &rhs, &solve);
+	if (err == EMD_SUCCESS && solve) {
+		_solve_spline_rhs(&rhs, NULL);
+	}
+	return err;
+}
+
+libeemd_error_code emd_update_envelope_coefficients(libeemd_interpolation interpolation,
+		double const* __restrict maxx, double const* __restrict maxy, size_t num_max,
+		double const* __restrict previous_maxx, spline_system* __restrict max_system,
+		double const* __restrict minx, double const* __restrict miny, size_t num_min,
+		double const* __restrict previous_minx, spline_system* __restrict min_system,
+		double* __restrict coeffs) {
+	if (interpolation != EMD_INTERP_SPLINE) {
+		libeemd_error_code err = emd_interpolant_coefficients(interpolation, maxx, maxy,
+				num_max, coeffs);
+		if (err != EMD_SUCCESS) {
+			return err;
+		}
+		return emd_interpolant_coefficients(interpolation, minx, miny, num_min, coeffs+num_max);
+	}
+	spline_rhs max_rhs;
+	spline_rhs min_rhs;
+	bool solve_max;
+	bool solve_min;
+	libeemd_error_code err = _prepare_spline(maxx, maxy, num_max, previous_maxx, max_system,
+			coeffs, &max_rhs, &solve_max);
+	if (err != EMD_SUCCESS) {
+		return err;
+	}
+	err = _prepare_spline(minx, miny, num_min, previous_minx, min_system, coeffs+num_max,
+			&min_rhs, &solve_min);
+	if (err != EMD_SUCCESS) {
+		return err;
+	}
+	if (solve_max && solve_min) {
+		_solve_spline_rhs(&max_rhs, &min_rhs);
+	}
+	else if (solve_max) {
+		_solve_spline_rhs(&max_rhs, NULL);
+	}
+	else if (solve_min) {
+		_solve_spline_rhs(&min_rhs, NULL);
 	}
 	return EMD_SUCCESS;
 }
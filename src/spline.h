@@ -20,12 +20,172 @@
 #define _EEMD_SPLINE_H_
 
 #include <assert.h>
+#include <limits.h>
 #include <math.h>
+#include <stdbool.h>
+#include <string.h>
 
-#include <gsl/gsl_vector.h>
-#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_errno.h>
 #include <gsl/gsl_poly.h>
 
 #include "eemd.h"
+#include "precision.h"
+
+// Solve the coefficients of the spline interpolating the N points (x, y) as
+// in emd_evaluate_spline to coeffs, which needs room for 3*N-4 doubles, or N
+// doubles if N <= 3. Only the first N doubles are needed for evaluating the
+// spline with a spline_cursor, so the rest can be reused after this returns.
+libeemd_error_code emd_spline_coefficients(double const* __restrict x, double const* __restrict y,
+		size_t N, double* __restrict coeffs);
+
+// Solve the coefficients of the interpolant of the N points (x, y) given by
+// interpolation to coeffs. For EMD_INTERP_SPLINE this is
+// emd_spline_coefficients. The other interpolants only depend on the
+// neighbouring points, and need room for N doubles: the slopes at the
+// points for EMD_INTERP_PCHIP and EMD_INTERP_AKIMA, and none for
+// EMD_INTERP_LINEAR.
+libeemd_error_code emd_interpolant_coefficients(libeemd_interpolation interpolation,
+		double const* __restrict x, double const* __restrict y, size_t N,
+		double* __restrict coeffs);
+
+// Gaussian elimination of the tridiagonal system solved for the spline
+// coefficients. The system only depends on the knots x, so it can be kept
+// between siftings and only partially eliminated again when the knots
+// change. All arrays need room for N-2 doubles.
+typedef struct {
+	// Number of knots of the eliminated system, or 0 if there is none
+	size_t N;
+	double* pivots;
+	double* multipliers;
+	// Memory for the next elimination, which is swapped with the above
+	// when it is done. These are only needed if the system is updated.
+	double* next_pivots;
+	double* next_multipliers;
+} spline_system;
+
+// Version of emd_spline_coefficients which keeps the elimination of the
+// spline system in system. If system has been eliminated for the knots
+// previous_x, only the rows near the knots that have changed are
+// eliminated again, and if no knots have changed only the right hand side
+// is solved. previous_x may be NULL. Only the first N doubles of coeffs
+// are used.
+libeemd_error_code emd_update_spline_coefficients(double const* __restrict x, double const* __restrict y,
+		size_t N, double const* __restrict previous_x, spline_system* __restrict system,
+		double* __restrict coeffs);
+
+// Version of emd_update_spline_coefficients for both envelopes of a
+// sifting, which solves the coefficients of the upper envelope to coeffs
+// and those of the lower envelope to coeffs+num_max. The right hand sides
+// of the two systems are solved in the same pass, interleaving their rows.
+// For interpolations other than EMD_INTERP_SPLINE the coefficients are
+// those of emd_interpolant_coefficients, and the systems are not used.
+libeemd_error_code emd_update_envelope_coefficients(libeemd_interpolation interpolation,
+		double const* __restrict maxx, double const* __restrict maxy, size_t num_max,
+		double const* __restrict previous_maxx, spline_system* __restrict max_system,
+		double const* __restrict minx, double const* __restrict miny, size_t num_min,
+		double const* __restrict previous_minx, spline_system* __restrict min_system,
+		double* __restrict coeffs);
+
+// Number of points evaluated at a time by emd_evaluate_spline
+#define SPLINE_BLOCK 256
+
+// Form of the interpolant evaluated by a spline_cursor
+typedef enum {
+	// Polynomial through the points, for a spline of at most 3 points
+	SPLINE_FORM_POLYNOMIAL,
+	// Cubic spline with the coefficients of emd_spline_coefficients
+	SPLINE_FORM_CUBIC,
+	// Straight lines between the points
+	SPLINE_FORM_LINEAR,
+	// Cubic Hermite interpolant with the slopes at the points as
+	// coefficients
+	SPLINE_FORM_HERMITE
+} spline_form;
+
+// Sequential evaluation of an interpolant solved with
+// emd_interpolant_coefficients at the integer points j = 0, 1, ..., x[N-1]
+// in increasing order. The cursor keeps track of the current interval and
+// the coefficients of its cubic, so that the interpolant can be evaluated
+// block by block while another array is being processed in the same pass.
+typedef struct {
+	double const* x;
+	double const* y;
+	double const* c;
+	size_t N;
+	spline_form form;
+	size_t i;
+	// Coefficients of the cubic a_i + b_i*dx + c_i*dx^2 + d_i*dx^3 of
+	// interval i, where dx = j-x[i], unless the form is polynomial
+	double a_i;
+	double b_i;
+	double c_i;
+	double d_i;
+} spline_cursor;
+
+// Compute the coefficients of the cubic of the current interval
+static inline void spline_cursor_interval(spline_cursor* s) {
+	double const* const x = s->x;
+	double const* const y = s->y;
+	double const* const c = s->c;
+	const size_t i = s->i;
+	const double h_i = x[i+1] - x[i];
+	s->a_i = y[i];
+	switch (s->form) {
+		case SPLINE_FORM_CUBIC :
+			s->b_i = (y[i+1]-y[i])/h_i - (h_i/3.0)*(c[i+1]+2*c[i]);
+			s->c_i = c[i];
+			s->d_i = (c[i+1]-c[i])/(3.0*h_i);
+			break;
+		case SPLINE_FORM_HERMITE : {
+			const double delta = (y[i+1]-y[i])/h_i;
+			s->b_i = c[i];
+			s->c_i = (3*delta - 2*c[i] - c[i+1])/h_i;
+			s->d_i = (c[i] + c[i+1] - 2*delta)/(h_i*h_i);
+			break;
+		}
+		default :
+			s->b_i = (y[i+1]-y[i])/h_i;
+			s->c_i = 0;
+			s->d_i = 0;
+	}
+}
+
+static inline void spline_cursor_begin(spline_cursor* s, libeemd_interpolation interpolation,
+		double const* x, double const* y, size_t N, double const* coeffs) {
+	s->x = x;
+	s->y = y;
+	s->c = coeffs;
+	s->N = N;
+	s->i = 0;
+	if (interpolation == EMD_INTERP_SPLINE) {
+		s->form = (N <= 3)? SPLINE_FORM_POLYNOMIAL : SPLINE_FORM_CUBIC;
+	}
+	else {
+		s->form = (interpolation == EMD_INTERP_LINEAR || N <= 2)?
+			SPLINE_FORM_LINEAR : SPLINE_FORM_HERMITE;
+	}
+	if (s->form != SPLINE_FORM_POLYNOMIAL && N >= 2) {
+		spline_cursor_interval(s);
+	}
+}
+
+// Write the values of the spline at j, j+1, ..., j+n-1 to values, where j
+// must be greater than the points of the previous call and n must fit in an
+// int. Each interval is evaluated with the Horner scheme in a SIMD loop.
+void spline_cursor_fill(spline_cursor* s, size_t j, size_t n, double* __restrict values);
+
+// Version of emd_evaluate_spline writing the spline values as floats. The
+// spline itself is computed in double precision.
+libeemd_error_code emd_evaluate_spline_f(double const* __restrict x, double const* __restrict y,
+		size_t N, float* __restrict spline_y, double* __restrict spline_workspace);
+
+// Versions of emd_evaluate_spline for the interpolant given by
+// interpolation, see emd_interpolant_coefficients
+libeemd_error_code emd_evaluate_interpolant(libeemd_interpolation interpolation,
+		double const* __restrict x, double const* __restrict y, size_t N,
+		double* __restrict spline_y, double* __restrict spline_workspace);
+libeemd_error_code emd_evaluate_interpolant_f(libeemd_interpolation interpolation,
+		double const* __restrict x, double const* __restrict y, size_t N,
+		float* __restrict spline_y, double* __restrict spline_workspace);
 
 #endif // _EEMD_SPLINE_H_
@@ -0,0 +1,38 @@
+/*
+ ** Precision-generic definitions of emd_evaluate_spline and
+ ** emd_evaluate_interpolant, see precision.h. The spline points and
+ ** coefficients are always doubles and solved with
+ ** emd_interpolant_coefficients in spline.c, and only the evaluated spline
+ ** has type EMD_REAL. This file is included by spline.c
+ ** once for each precision, so it has no include guard.
+ */
+
+libeemd_error_code EMD_NAME(emd_evaluate_interpolant)(libeemd_interpolation interpolation,
+		double const* __restrict x, double const* __restrict y, size_t N,
+		EMD_REAL* __restrict spline_y, double* __restrict spline_workspace) {
+	libeemd_error_code err = emd_interpolant_coefficients(interpolation, x, y, N,
+			spline_workspace);
+	if (err != EMD_SUCCESS) {
+		return err;
+	}
+	// The evaluation points j just increase monotonically from 0 to max_j,
+	// so the spline is evaluated with a cursor in blocks
+	const size_t num_j = (size_t)x[N-1] + 1;
+	spline_cursor s;
+	spline_cursor_begin(&s, interpolation, x, y, N, spline_workspace);
+	double values[SPLINE_BLOCK];
+	for (size_t j=0; j<num_j; j+=SPLINE_BLOCK) {
+		const size_t n = (num_j-j < SPLINE_BLOCK)? num_j-j : SPLINE_BLOCK;
+		spline_cursor_fill(&s, j, n, values);
+		for (size_t k=0; k<n; k++) {
+			spline_y[j+k] = (EMD_REAL)values[k];
+		}
+	}
+	return EMD_SUCCESS;
+}
+
+libeemd_error_code EMD_NAME(emd_evaluate_spline)(double const* __restrict x, double const* __restrict y,
+		size_t N, EMD_REAL* __restrict spline_y, double* __restrict spline_workspace) {
+	return EMD_NAME(emd_evaluate_interpolant)(EMD_INTERP_SPLINE, x, y, N, spline_y,
+			spline_workspace);
+}
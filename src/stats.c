@@ -0,0 +1,135 @@
+/*
+ ** Instrumentation of the decomposition routines for Rlibeemd, see stats.h
+ */
+
+#include "stats.h"
+
+emd_stats* allocate_emd_stats(void) {
+	emd_stats* stats = malloc(sizeof(emd_stats));
+	stats->num_imfs = 0;
+	stats->sift_runs = NULL;
+	stats->sift_min = NULL;
+	stats->sift_mean = NULL;
+	stats->sift_max = NULL;
+	stats->extrema_mean = NULL;
+	stats->extrema_time = 0;
+	stats->spline_time = 0;
+	stats->accumulate_time = 0;
+	stats->wall_time = 0;
+	stats->num_threads = 0;
+	stats->busy_time = NULL;
+	stats->idle_time = NULL;
+	return stats;
+}
+
+void free_emd_stats(emd_stats* stats) {
+	free(stats->idle_time); stats->idle_time = NULL;
+	free(stats->busy_time); stats->busy_time = NULL;
+	free(stats->extrema_mean); stats->extrema_mean = NULL;
+	free(stats->sift_max); stats->sift_max = NULL;
+	free(stats->sift_mean); stats->sift_mean = NULL;
+	free(stats->sift_min); stats->sift_min = NULL;
+	free(stats->sift_runs); stats->sift_runs = NULL;
+	free(stats); stats = NULL;
+}
+
+emd_thread_stats* allocate_thread_stats(size_t num_threads, size_t num_imfs) {
+	emd_thread_stats* s = malloc(num_threads*sizeof(emd_thread_stats));
+	for (size_t thread_i=0; thread_i<num_threads; thread_i++) {
+		s[thread_i].num_imfs = num_imfs;
+		s[thread_i].sift_runs = calloc(num_imfs, sizeof(size_t));
+		s[thread_i].sift_min = calloc(num_imfs, sizeof(unsigned int));
+		s[thread_i].sift_max = calloc(num_imfs, sizeof(unsigned int));
+		s[thread_i].sift_total = calloc(num_imfs, sizeof(size_t));
+		s[thread_i].extrema_total = calloc(num_imfs, sizeof(size_t));
+		s[thread_i].extrema_time = 0;
+		s[thread_i].spline_time = 0;
+		s[thread_i].accumulate_time = 0;
+		s[thread_i].busy_time = 0;
+	}
+	return s;
+}
+
+void free_thread_stats(emd_thread_stats* s, size_t num_threads) {
+	for (size_t thread_i=0; thread_i<num_threads; thread_i++) {
+		free(s[thread_i].extrema_total);
+		free(s[thread_i].sift_total);
+		free(s[thread_i].sift_max);
+		free(s[thread_i].sift_min);
+		free(s[thread_i].sift_runs);
+	}
+	free(s);
+}
+
+void record_sifting(emd_thread_stats* s, size_t imf_i, unsigned int sift_count,
+		size_t num_extrema) {
+	if (imf_i >= s->num_imfs) {
+		return;
+	}
+	if (s->sift_runs[imf_i] == 0 || sift_count < s->sift_min[imf_i]) {
+		s->sift_min[imf_i] = sift_count;
+	}
+	if (sift_count > s->sift_max[imf_i]) {
+		s->sift_max[imf_i] = sift_count;
+	}
+	s->sift_runs[imf_i]++;
+	s->sift_total[imf_i] += sift_count;
+	s->extrema_total[imf_i] += num_extrema;
+}
+
+void collect_emd_stats(emd_stats* stats, emd_thread_stats const* s,
+		size_t num_threads, double wall_time) {
+	const size_t M = (num_threads > 0)? s[0].num_imfs : 0;
+	if (M > stats->num_imfs) {
+		stats->sift_runs = realloc(stats->sift_runs, M*sizeof(size_t));
+		stats->sift_min = realloc(stats->sift_min, M*sizeof(unsigned int));
+		stats->sift_mean = realloc(stats->sift_mean, M*sizeof(double));
+		stats->sift_max = realloc(stats->sift_max, M*sizeof(unsigned int));
+		stats->extrema_mean = realloc(stats->extrema_mean, M*sizeof(double));
+	}
+	stats->num_imfs = M;
+	if (num_threads > stats->num_threads) {
+		stats->busy_time = realloc(stats->busy_time, num_threads*sizeof(double));
+		stats->idle_time = realloc(stats->idle_time, num_threads*sizeof(double));
+	}
+	stats->num_threads = num_threads;
+	stats->extrema_time = 0;
+	stats->spline_time = 0;
+	stats->accumulate_time = 0;
+	stats->wall_time = wall_time;
+	for (size_t imf_i=0; imf_i<M; imf_i++) {
+		size_t runs = 0;
+		size_t sift_total = 0;
+		size_t extrema_total = 0;
+		unsigned int sift_min = 0;
+		unsigned int sift_max = 0;
+		for (size_t thread_i=0; thread_i<num_threads; thread_i++) {
+			const size_t thread_runs = s[thread_i].sift_runs[imf_i];
+			if (thread_runs == 0) {
+				continue;
+			}
+			if (runs == 0 || s[thread_i].sift_min[imf_i] < sift_min) {
+				sift_min = s[thread_i].sift_min[imf_i];
+			}
+			if (s[thread_i].sift_max[imf_i] > sift_max) {
+				sift_max = s[thread_i].sift_max[imf_i];
+			}
+			runs += thread_runs;
+			sift_total += s[thread_i].sift_total[imf_i];
+			extrema_total += s[thread_i].extrema_total[imf_i];
+		}
+		stats->sift_runs[imf_i] = runs;
+		stats->sift_min[imf_i] = sift_min;
+		stats->sift_max[imf_i] = sift_max;
+		stats->sift_mean[imf_i] = (runs > 0)? (double)sift_total/runs : 0;
+		stats->extrema_mean[imf_i] = (runs > 0)? (double)extrema_total/runs : 0;
+	}
+	for (size_t thread_i=0; thread_i<num_threads; thread_i++) {
+		stats->extrema_time += s[thread_i].extrema_time;
+		stats->spline_time += s[thread_i].spline_time;
+		stats->accumulate_time += s[thread_i].accumulate_time;
+		stats->busy_time[thread_i] = s[thread_i].busy_time;
+		stats->idle_time[thread_i] = (wall_time > s[thread_i].busy_time)?
+			wall_time-s[thread_i].busy_time : 0;
+	}
+}
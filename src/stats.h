@@ -0,0 +1,58 @@
+/*
+ ** Instrumentation of the decomposition routines for Rlibeemd:
+ ** Each thread collects its statistics to its own emd_thread_stats without
+ ** synchronization, and the results are combined to the public emd_stats
+ ** after the parallel region. When no statistics are requested the thread
+ ** statistics pointers are NULL, and the only overhead is checking them.
+ */
+
+#ifndef _EEMD_STATS_H_
+#define _EEMD_STATS_H_
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "eemd.h"
+
+typedef struct {
+	// Per-IMF sums over the sifting runs of this thread, see emd_stats
+	size_t num_imfs;
+	size_t* sift_runs;
+	unsigned int* sift_min;
+	unsigned int* sift_max;
+	size_t* sift_total;
+	size_t* extrema_total;
+	double extrema_time;
+	double spline_time;
+	double accumulate_time;
+	double busy_time;
+} emd_thread_stats;
+
+// Current time in seconds for measuring durations
+static inline double emd_wtime(void) {
+	#ifdef _OPENMP
+	return omp_get_wtime();
+	#else
+	return (double)clock()/CLOCKS_PER_SEC;
+	#endif
+}
+
+// Allocate zeroed statistics for num_threads threads and num_imfs IMFs
+emd_thread_stats* allocate_thread_stats(size_t num_threads, size_t num_imfs);
+void free_thread_stats(emd_thread_stats* s, size_t num_threads);
+
+// Record a sifting run that produced IMF imf_i after sift_count siftings,
+// with num_extrema extrema in the last sifting
+void record_sifting(emd_thread_stats* s, size_t imf_i, unsigned int sift_count,
+		size_t num_extrema);
+
+// Combine the statistics of num_threads threads into stats. The wall clock
+// time of the parallel region is given by wall_time.
+void collect_emd_stats(emd_stats* stats, emd_thread_stats const* s,
+		size_t num_threads, double wall_time);
+
+#endif // _EEMD_STATS_H_
@@ -0,0 +1,31 @@
+#include "statsR.h"
+
+using namespace Rcpp;
+
+SEXP stats_list(emd_stats* stats) {
+  if (stats == NULL) {
+    return R_NilValue;
+  }
+  size_t M = stats->num_imfs;
+  NumericVector runs(M), sift_min(M), sift_mean(M), sift_max(M), extrema(M);
+  for (size_t i = 0; i < M; i++) {
+    runs[i] = (double)stats->sift_runs[i];
+    sift_min[i] = stats->sift_min[i];
+    sift_mean[i] = stats->sift_mean[i];
+    sift_max[i] = stats->sift_max[i];
+    extrema[i] = stats->extrema_mean[i];
+  }
+  size_t T = stats->num_threads;
+  NumericVector busy(stats->busy_time, stats->busy_time + T);
+  NumericVector idle(stats->idle_time, stats->idle_time + T);
+  NumericVector time = NumericVector::create(
+    Named("extrema") = stats->extrema_time, Named("spline") = stats->spline_time,
+    Named("accumulate") = stats->accumulate_time, Named("wall") = stats->wall_time);
+  free_emd_stats(stats);
+  return List::create(
+    Named("imfs") = DataFrame::create(Named("runs") = runs, 
+      Named("sift_min") = sift_min, Named("sift_mean") = sift_mean, 
+      Named("sift_max") = sift_max, Named("extrema") = extrema),
+    Named("time") = time,
+    Named("threads") = DataFrame::create(Named("busy") = busy, Named("idle") = idle));
+}
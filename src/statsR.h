@@ -0,0 +1,15 @@
+#ifndef STATSR_H
+#define STATSR_H
+
+#include <Rcpp.h>
+
+extern "C"
+{
+  #include "eemd.h"
+}
+
+// Convert the statistics to an R list and free them. Returns NULL in R if
+// stats is NULL, so the result can always be set as the attribute "stats".
+SEXP stats_list(emd_stats* stats);
+
+#endif
@@ -0,0 +1,26 @@
+#include "stoppingR.h"
+
+using namespace Rcpp;
+
+emd_stopping const* stopping_criterion(int stopping, SEXP thresholds,
+  emd_stopping* criterion) {
+  if (stopping == EMD_STOP_S_NUMBER) {
+    return NULL;
+  }
+  criterion->criterion = (libeemd_stopping)stopping;
+  criterion->sd_limit = 0;
+  criterion->theta_1 = 0;
+  criterion->theta_2 = 0;
+  criterion->alpha = 0;
+  // Missing thresholds are left to zero, which the routines reject
+  NumericVector t = (thresholds == R_NilValue) ? NumericVector(0) : as<NumericVector>(thresholds);
+  if (stopping == EMD_STOP_SD && t.size() >= 1) {
+    criterion->sd_limit = t[0];
+  }
+  if (stopping == EMD_STOP_RILLING && t.size() >= 3) {
+    criterion->theta_1 = t[0];
+    criterion->theta_2 = t[1];
+    criterion->alpha = t[2];
+  }
+  return criterion;
+}
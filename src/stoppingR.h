@@ -0,0 +1,18 @@
+#ifndef STOPPINGR_H
+#define STOPPINGR_H
+
+#include <Rcpp.h>
+
+extern "C"
+{
+  #include "eemd.h"
+}
+
+// Fill criterion with the stopping criterion given to the R functions, where
+// stopping is the value of libeemd_stopping and thresholds is a numeric
+// vector of its thresholds, or NULL. Returns NULL for the S-number, so the
+// result can be passed to the decomposition routines as is.
+emd_stopping const* stopping_criterion(int stopping, SEXP thresholds,
+  emd_stopping* criterion);
+
+#endif
@@ -18,62 +18,106 @@
 
 #include "workspace.h"
 
-// sifting_workspace
+#define EMD_REAL double
+#define EMD_SUFFIX
+#include "workspace_impl.h"
+#undef EMD_SUFFIX
+#undef EMD_REAL
+#define EMD_REAL float
+#define EMD_SUFFIX _f
+#include "workspace_impl.h"
+#undef EMD_SUFFIX
+#undef EMD_REAL
 
-sifting_workspace* allocate_sifting_workspace(size_t N) {
-	sifting_workspace* w = malloc(sizeof(sifting_workspace));
+// eemd_workspace
+
+static eemd_workspace* _take_eemd_workspace(emd_arena* a, size_t N, libeemd_precision precision) {
+	eemd_workspace* w = emd_arena_take(a, 1, sizeof(eemd_workspace));
+	double* const noise = emd_arena_take(a, N, sizeof(double));
+	double* x = NULL;
+	float* x_f = NULL;
+	emd_workspace* emd_w = NULL;
+	emd_workspace_f* emd_w_f = NULL;
+	if (precision == EMD_FLOAT) {
+		x_f = emd_arena_take(a, N, sizeof(float));
+		emd_w_f = take_emd_workspace_f(a, N);
+	}
+	else {
+		x = emd_arena_take(a, N, sizeof(double));
+		emd_w = take_emd_workspace(a, N);
+	}
+	if (w == NULL) {
+		return NULL;
+	}
 	w->N = N;
-	w->maxx = malloc(N*sizeof(double));
-	w->maxy = malloc(N*sizeof(double));
-	w->minx = malloc(N*sizeof(double));
-	w->miny = malloc(N*sizeof(double));
-	w->maxspline = malloc(N*sizeof(double));
-	w->minspline = malloc(N*sizeof(double));
-	// Spline evaluation requires 5*m-10 doubles where m is the number of
-	// extrema. The worst case scenario is that every point is an extrema, so
-	// use m=N to be safe.
-	const size_t spline_workspace_size = (N > 2)? 5*N-10 : 0;
-	w->spline_workspace = malloc(spline_workspace_size*sizeof(double));
+	w->capacity = N;
+	w->precision = precision;
+	w->noise = noise;
+	w->x = x;
+	w->x_f = x_f;
+	w->emd_w = emd_w;
+	w->emd_w_f = emd_w_f;
+	w->stats = NULL;
 	return w;
 }
 
-void free_sifting_workspace(sifting_workspace* w) {
-	free(w->spline_workspace); w->spline_workspace = NULL;
-	free(w->minspline); w->minspline = NULL;
-	free(w->maxspline); w->maxspline = NULL;
-	free(w->miny); w->miny = NULL;
-	free(w->minx); w->minx = NULL;
-	free(w->maxy); w->maxy = NULL;
-	free(w->maxx); w->maxx = NULL;
-	free(w); w = NULL;
+eemd_workspace* allocate_eemd_workspace(size_t N, libeemd_precision precision) {
+	emd_arena a = emd_arena_sizing();
+	_take_eemd_workspace(&a, N, precision);
+	if (!emd_arena_allocate(&a)) {
+		return NULL;
+	}
+	eemd_workspace* w = _take_eemd_workspace(&a, N, precision);
+	w->arena = a;
+	w->r = gsl_rng_alloc(gsl_rng_mt19937);
+	return w;
 }
 
-// emd_workspace
-
-emd_workspace* allocate_emd_workspace(size_t N) {
-	emd_workspace* w = malloc(sizeof(emd_workspace));
+void set_eemd_workspace_length(eemd_workspace* w, size_t N) {
 	w->N = N;
-	w->res = malloc(N*sizeof(double));
-	w->sift_w = allocate_sifting_workspace(N);
-	w->locks = NULL; // The locks are assumed to be allocated and freed independently
-	return w;
+	if (w->emd_w != NULL) {
+		set_emd_workspace_length(w->emd_w, N);
+	}
+	if (w->emd_w_f != NULL) {
+		set_emd_workspace_length_f(w->emd_w_f, N);
+	}
 }
 
-void free_emd_workspace(emd_workspace* w) {
-	free_sifting_workspace(w->sift_w);
-	free(w->res); w->res = NULL;
-	free(w); w = NULL;
+void set_eemd_workspace_locks(eemd_workspace* w, lock** locks) {
+	if (w->emd_w != NULL) {
+		w->emd_w->locks = locks;
+	}
+	if (w->emd_w_f != NULL) {
+		w->emd_w_f->locks = locks;
+	}
 }
 
-// emd_workspace
+void set_eemd_workspace_stats(eemd_workspace* w, emd_thread_stats* stats) {
+	w->stats = stats;
+	if (w->emd_w != NULL) {
+		w->emd_w->sift_w->stats = stats;
+	}
+	if (w->emd_w_f != NULL) {
+		w->emd_w_f->sift_w->stats = stats;
+	}
+}
 
-eemd_workspace* allocate_eemd_workspace(size_t N) {
-	eemd_workspace* w = malloc(sizeof(eemd_workspace));
-	w->N = N;
-	w->r = gsl_rng_alloc(gsl_rng_mt19937);
-	w->x = malloc(N*sizeof(double));
-	w->emd_w = allocate_emd_workspace(N);
-	return w;
+void set_eemd_workspace_stopping(eemd_workspace* w, emd_stopping const* stopping) {
+	if (w->emd_w != NULL) {
+		w->emd_w->sift_w->stopping = stopping;
+	}
+	if (w->emd_w_f != NULL) {
+		w->emd_w_f->sift_w->stopping = stopping;
+	}
+}
+
+void set_eemd_workspace_interpolation(eemd_workspace* w, libeemd_interpolation interpolation) {
+	if (w->emd_w != NULL) {
+		w->emd_w->sift_w->interpolation = interpolation;
+	}
+	if (w->emd_w_f != NULL) {
+		w->emd_w_f->sift_w->interpolation = interpolation;
+	}
 }
 
 void set_rng_seed(eemd_workspace* w, unsigned long int rng_seed) {
@@ -81,8 +125,8 @@ void set_rng_seed(eemd_workspace* w, unsigned long int rng_seed) {
 }
 
 void free_eemd_workspace(eemd_workspace* w) {
-	free_emd_workspace(w->emd_w);
-	free(w->x); w->x = NULL;
 	gsl_rng_free(w->r); w->r = NULL;
-	free(w); w = NULL;
+	// The EMD workspaces and the workspace itself are in the arena
+	emd_arena a = w->arena;
+	emd_arena_free(&a);
 }
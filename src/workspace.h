@@ -23,60 +23,67 @@
 #include <stdlib.h>
 #include <gsl/gsl_rng.h>
 
+#include "arena.h"
 #include "lock.h"
+#include "precision.h"
+#include "spline.h"
+#include "stats.h"
+#include "eemd.h"
 
 // Necessary workspace memory structures for various EMD operations
 
-// For sifting we need arrays for storing the found extrema of the signal, and memory required
-// to form the spline envelopes
-typedef struct {
-	// Number of samples in the signal
-	size_t N;
-	// Found extrema
-	double* __restrict maxx;
-	double* __restrict maxy;
-	double* __restrict minx;
-	double* __restrict miny;
-	// Upper and lower envelope spline values
-	double* __restrict maxspline;
-	double* __restrict minspline;
-	// Extra memory required for spline evaluation
-	double* __restrict spline_workspace;
-} sifting_workspace;
-
-sifting_workspace* allocate_sifting_workspace(size_t N);
-void free_sifting_workspace(sifting_workspace* w);
-
-// For EMD we need space to do the sifting and somewhere to save the residual from the previous run.
-// We also leave room for an array of locks to protect multi-threaded EMD.
-typedef struct {
-	size_t N;
-	// Previous residual for EMD
-	double* __restrict res;
-	// What is needed for sifting
-	sifting_workspace* __restrict sift_w;
-	// A pointer for shared locks. These locks are used to make EMD thread-safe
-	// even when several threads run EMD with the same output matrix (we'll do
-	// this in EEMD).
-	lock** locks;
-} emd_workspace;
-
-emd_workspace* allocate_emd_workspace(size_t N);
-void free_emd_workspace(emd_workspace* w);
+// Sifting and EMD workspaces for double (sifting_workspace, emd_workspace)
+// and float signals (sifting_workspace_f, emd_workspace_f)
+#define EMD_REAL double
+#define EMD_SUFFIX
+#include "workspace_template.h"
+#undef EMD_SUFFIX
+#undef EMD_REAL
+#define EMD_REAL float
+#define EMD_SUFFIX _f
+#include "workspace_template.h"
+#undef EMD_SUFFIX
+#undef EMD_REAL
 
 // EEMD needs a random number generator in addition to emd_workspace. We also need a place to store
-// the member of the ensemble (input signal + realization of noise) to be worked on.
+// the member of the ensemble (input signal + realization of noise) to be worked on. Apart from the
+// random number generator, everything a thread needs is taken from a single arena.
 typedef struct {
 	size_t N;
+	// Length of the longest signal the workspace has room for
+	size_t capacity;
 	// The random number generator
 	gsl_rng* r;
+	// Precision of the signal processed by EMD. Only the arrays of this
+	// precision are allocated, and the others are NULL.
+	libeemd_precision precision;
 	// The ensemble member signal
 	double* __restrict x;
+	float* __restrict x_f;
+	// The realization of noise, kept for the complementary member in
+	// complementary EEMD
+	double* __restrict noise;
 	// What is needed for running EMD
 	emd_workspace* __restrict emd_w;
+	emd_workspace_f* __restrict emd_w_f;
+	// Statistics of the thread using the workspace, or NULL
+	emd_thread_stats* stats;
+	// Memory of the workspace and of emd_w or emd_w_f
+	emd_arena arena;
 } eemd_workspace;
 
-eemd_workspace* allocate_eemd_workspace(size_t N);
+eemd_workspace* allocate_eemd_workspace(size_t N, libeemd_precision precision);
+// Same as set_emd_workspace_length, so that the same workspace can be reused
+// for shorter signals
+void set_eemd_workspace_length(eemd_workspace* w, size_t N);
+// Set the locks used by EMD for the shared output matrix
+void set_eemd_workspace_locks(eemd_workspace* w, lock** locks);
+// Set the statistics collected by the thread using the workspace, or NULL
+void set_eemd_workspace_stats(eemd_workspace* w, emd_thread_stats* stats);
+// Set the stopping criterion of the sifting, or NULL for the S-number
+void set_eemd_workspace_stopping(eemd_workspace* w, emd_stopping const* stopping);
+// Set the interpolation of the envelopes in the sifting
+void set_eemd_workspace_interpolation(eemd_workspace* w, libeemd_interpolation interpolation);
 void set_rng_seed(eemd_workspace* w, unsigned long int rng_seed);
 void free_eemd_workspace(eemd_workspace* w);
 
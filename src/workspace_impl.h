@@ -0,0 +1,109 @@
+/*
+ ** Precision-generic definitions of the workspace routines declared in
+ ** workspace_template.h. This file is included by workspace.c once for each
+ ** precision, so it has no include guard.
+ */
+
+// sifting_workspace
+
+EMD_NAME(sifting_workspace)* EMD_NAME(take_sifting_workspace)(emd_arena* a, size_t N) {
+	EMD_NAME(sifting_workspace)* w = emd_arena_take(a, 1, sizeof(EMD_NAME(sifting_workspace)));
+	// The maxima and minima alternate, so including the end points there are
+	// at most N/2+2 of each
+	const size_t max_extrema = N/2+2;
+	double* extrema[8];
+	for (size_t k=0; k<8; k++) {
+		extrema[k] = emd_arena_take(a, max_extrema, sizeof(double));
+	}
+	// The spline of m extrema has m coefficients, and its system has m-2
+	// pivots and multipliers, which are double buffered. The coefficients
+	// of the lower envelope are stored after those of the upper envelope.
+	double* const spline_workspace = emd_arena_take(a, 2*max_extrema, sizeof(double));
+	double* system_memory[8];
+	for (size_t k=0; k<8; k++) {
+		system_memory[k] = emd_arena_take(a, max_extrema, sizeof(double));
+	}
+	if (w == NULL) {
+		return NULL;
+	}
+	w->N = N;
+	w->maxx = extrema[0];
+	w->maxy = extrema[1];
+	w->minx = extrema[2];
+	w->miny = extrema[3];
+	w->next_maxx = extrema[4];
+	w->next_maxy = extrema[5];
+	w->next_minx = extrema[6];
+	w->next_miny = extrema[7];
+	w->spline_workspace = spline_workspace;
+	spline_system* systems[2] = {&w->max_system, &w->min_system};
+	for (size_t k=0; k<2; k++) {
+		systems[k]->N = 0;
+		systems[k]->pivots = system_memory[4*k];
+		systems[k]->multipliers = system_memory[4*k+1];
+		systems[k]->next_pivots = system_memory[4*k+2];
+		systems[k]->next_multipliers = system_memory[4*k+3];
+	}
+	w->num_extrema = 0;
+	w->stats = NULL;
+	w->stopping = NULL;
+	w->interpolation = EMD_INTERP_SPLINE;
+	w->arena = emd_arena_sizing();
+	return w;
+}
+
+EMD_NAME(sifting_workspace)* EMD_NAME(allocate_sifting_workspace)(size_t N) {
+	emd_arena a = emd_arena_sizing();
+	EMD_NAME(take_sifting_workspace)(&a, N);
+	if (!emd_arena_allocate(&a)) {
+		return NULL;
+	}
+	EMD_NAME(sifting_workspace)* w = EMD_NAME(take_sifting_workspace)(&a, N);
+	w->arena = a;
+	return w;
+}
+
+void EMD_NAME(free_sifting_workspace)(EMD_NAME(sifting_workspace)* w) {
+	// The workspace itself is in the arena
+	emd_arena a = w->arena;
+	emd_arena_free(&a);
+}
+
+// emd_workspace
+
+EMD_NAME(emd_workspace)* EMD_NAME(take_emd_workspace)(emd_arena* a, size_t N) {
+	EMD_NAME(emd_workspace)* w = emd_arena_take(a, 1, sizeof(EMD_NAME(emd_workspace)));
+	EMD_REAL* const res = emd_arena_take(a, N, sizeof(EMD_REAL));
+	EMD_NAME(sifting_workspace)* const sift_w = EMD_NAME(take_sifting_workspace)(a, N);
+	if (w == NULL) {
+		return NULL;
+	}
+	w->N = N;
+	w->res = res;
+	w->sift_w = sift_w;
+	w->locks = NULL; // The locks are assumed to be allocated and freed independently
+	w->arena = emd_arena_sizing();
+	return w;
+}
+
+EMD_NAME(emd_workspace)* EMD_NAME(allocate_emd_workspace)(size_t N) {
+	emd_arena a = emd_arena_sizing();
+	EMD_NAME(take_emd_workspace)(&a, N);
+	if (!emd_arena_allocate(&a)) {
+		return NULL;
+	}
+	EMD_NAME(emd_workspace)* w = EMD_NAME(take_emd_workspace)(&a, N);
+	w->arena = a;
+	return w;
+}
+
+void EMD_NAME(set_emd_workspace_length)(EMD_NAME(emd_workspace)* w, size_t N) {
+	w->N = N;
+	w->sift_w->N = N;
+}
+
+void EMD_NAME(free_emd_workspace)(EMD_NAME(emd_workspace)* w) {
+	EMD_NAME(free_sifting_workspace)(w->sift_w);
+	emd_arena a = w->arena;
+	emd_arena_free(&a);
+}
@@ -0,0 +1,70 @@
+/*
+ ** Precision-generic sifting and EMD workspaces for Rlibeemd, see
+ ** precision.h. This file is included by workspace.h once for each
+ ** precision, so it has no include guard.
+ */
+
+// For sifting we need arrays for storing the found extrema of the signal, and memory required
+// to form the spline envelopes
+typedef struct {
+	// Number of samples in the signal
+	size_t N;
+	// Found extrema. The extrema for the next sifting are found while the
+	// envelopes of the current ones are subtracted, so they are stored in a
+	// second set of arrays, and the sets are swapped after each sifting.
+	double* maxx;
+	double* maxy;
+	double* minx;
+	double* miny;
+	double* next_maxx;
+	double* next_maxy;
+	double* next_minx;
+	double* next_miny;
+	// Spline coefficients of both envelopes, followed by the memory of the
+	// spline systems below
+	double* __restrict spline_workspace;
+	// Eliminated spline systems of the upper and lower envelopes, kept
+	// between the siftings of an IMF
+	spline_system max_system;
+	spline_system min_system;
+	// Number of extrema found in the last sifting
+	size_t num_extrema;
+	// Statistics of the thread using the workspace, or NULL if no statistics
+	// are collected
+	emd_thread_stats* stats;
+	// Stopping criterion of the sifting, or NULL for the S-number
+	emd_stopping const* stopping;
+	// Interpolation of the envelopes
+	libeemd_interpolation interpolation;
+	// Memory of the workspace, or an empty arena if the workspace was taken
+	// from the arena of another workspace
+	emd_arena arena;
+} EMD_NAME(sifting_workspace);
+
+// Take a sifting workspace for signals of length N from a, see arena.h
+EMD_NAME(sifting_workspace)* EMD_NAME(take_sifting_workspace)(emd_arena* a, size_t N);
+EMD_NAME(sifting_workspace)* EMD_NAME(allocate_sifting_workspace)(size_t N);
+void EMD_NAME(free_sifting_workspace)(EMD_NAME(sifting_workspace)* w);
+
+// For EMD we need space to do the sifting and somewhere to save the residual from the previous run.
+// We also leave room for an array of locks to protect multi-threaded EMD.
+typedef struct {
+	size_t N;
+	// Previous residual for EMD
+	EMD_REAL* __restrict res;
+	// What is needed for sifting
+	EMD_NAME(sifting_workspace)* __restrict sift_w;
+	// A pointer for shared locks. These locks are used to make EMD thread-safe
+	// even when several threads run EMD with the same output matrix (we'll do
+	// this in EEMD). If the output matrix is not shared, this can be NULL.
+	lock** locks;
+	// Memory of the workspace, as in sifting_workspace
+	emd_arena arena;
+} EMD_NAME(emd_workspace);
+
+EMD_NAME(emd_workspace)* EMD_NAME(take_emd_workspace)(emd_arena* a, size_t N);
+EMD_NAME(emd_workspace)* EMD_NAME(allocate_emd_workspace)(size_t N);
+// Set the length of the signal processed with the workspace. This must not
+// exceed the length the workspace was allocated for.
+void EMD_NAME(set_emd_workspace_length)(EMD_NAME(emd_workspace)* w, size_t N);
+void EMD_NAME(free_emd_workspace)(EMD_NAME(emd_workspace)* w);